@@ -0,0 +1,150 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+namespace minx::zmesh::benchmark {
+
+namespace {
+
+void WriteString(std::ostream& out, std::string_view value) {
+    out << '"';
+    for (const char c : value) {
+        switch (c) {
+        case '"':
+            out << "\\\"";
+            break;
+        case '\\':
+            out << "\\\\";
+            break;
+        case '\n':
+            out << "\\n";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                out << escaped;
+            } else {
+                out << c;
+            }
+        }
+    }
+    out << '"';
+}
+
+void WriteValue(std::ostream& out, const Value& value) {
+    if (const auto* integer = std::get_if<std::int64_t>(&value)) {
+        out << *integer;
+    } else if (const auto* real = std::get_if<double>(&value)) {
+        // JSON has no NaN or infinity.
+        if (!std::isfinite(*real)) {
+            out << "null";
+            return;
+        }
+        char number[32];
+        std::snprintf(number, sizeof(number), "%.6g", *real);
+        out << number;
+    } else {
+        WriteString(out, std::get<std::string>(value));
+    }
+}
+
+void WriteObject(std::ostream& out, const std::vector<std::pair<std::string, Value>>& fields) {
+    out << '{';
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+        if (i != 0) {
+            out << ',';
+        }
+        WriteString(out, fields[i].first);
+        out << ':';
+        WriteValue(out, fields[i].second);
+    }
+    out << '}';
+}
+
+std::string UtcTimestamp() {
+    const auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm utc{};
+    gmtime_r(&now, &utc);
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return timestamp;
+}
+
+} // namespace
+
+Context::Context(bool quick, std::uint16_t base_port)
+    : quick_(quick),
+      next_port_(base_port) {}
+
+std::size_t Context::Scale(std::size_t count) const noexcept {
+    return quick_ ? std::max<std::size_t>(count / 10, 1) : count;
+}
+
+std::chrono::milliseconds Context::Scale(std::chrono::milliseconds duration) const noexcept {
+    return quick_ ? std::max(duration / 10, std::chrono::milliseconds{50}) : duration;
+}
+
+std::string Context::NextAddress() {
+    return "127.0.0.1:" + std::to_string(next_port_++);
+}
+
+void Context::Report(Result result) {
+    // One line per result for whoever watches the run; the JSON is the record.
+    std::string line = result.name;
+    for (const auto& fields : {&result.params, &result.metrics}) {
+        for (const auto& [key, value] : *fields) {
+            line += ' ' + key + '=';
+            if (const auto* integer = std::get_if<std::int64_t>(&value)) {
+                line += std::to_string(*integer);
+            } else if (const auto* real = std::get_if<double>(&value)) {
+                char number[32];
+                std::snprintf(number, sizeof(number), "%.4g", *real);
+                line += number;
+            } else {
+                line += std::get<std::string>(value);
+            }
+        }
+        if (fields == &result.params) {
+            line += " |";
+        }
+    }
+    std::fprintf(stderr, "%s\n", line.c_str());
+    results_.push_back(std::move(result));
+}
+
+void AddLatency(Result& result, std::string_view prefix, const HistogramSnapshot& snapshot) {
+    const auto microseconds = [](std::chrono::nanoseconds value) {
+        return std::chrono::duration<double, std::micro>(value).count();
+    };
+    const std::string name(prefix);
+    result.metrics.emplace_back(name + "_p50_us", microseconds(snapshot.Percentile(50)));
+    result.metrics.emplace_back(name + "_p99_us", microseconds(snapshot.Percentile(99)));
+    result.metrics.emplace_back(name + "_p999_us", microseconds(snapshot.Percentile(99.9)));
+    result.metrics.emplace_back(name + "_max_us", microseconds(snapshot.max));
+    result.metrics.emplace_back(name + "_mean_us", microseconds(snapshot.Mean()));
+}
+
+void WriteJson(std::ostream& out, const Context& context) {
+    out << "{\"suite\":\"minx-zmesh-native\",\"timestamp\":";
+    WriteString(out, UtcTimestamp());
+    out << ",\"hardware_concurrency\":" << std::thread::hardware_concurrency()
+        << ",\"quick\":" << (context.quick() ? "true" : "false") << ",\"results\":[";
+    const auto& results = context.results();
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        out << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+        WriteString(out, results[i].name);
+        out << ",\"params\":";
+        WriteObject(out, results[i].params);
+        out << ",\"metrics\":";
+        WriteObject(out, results[i].metrics);
+        out << '}';
+    }
+    out << "\n]}\n";
+}
+
+} // namespace minx::zmesh::benchmark
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "minx/zmesh/metrics.hpp"
+
+namespace minx::zmesh::benchmark {
+
+using Value = std::variant<std::int64_t, double, std::string>;
+
+// One measured configuration of a benchmark, e.g. Tell throughput at one
+// payload size.
+struct Result {
+    std::string name;
+    std::vector<std::pair<std::string, Value>> params;
+    std::vector<std::pair<std::string, Value>> metrics;
+};
+
+class Context {
+public:
+    Context(bool quick, std::uint16_t base_port);
+
+    [[nodiscard]] bool quick() const noexcept {
+        return quick_;
+    }
+
+    // Message counts and run times, cut down to a tenth for --quick.
+    [[nodiscard]] std::size_t Scale(std::size_t count) const noexcept;
+    [[nodiscard]] std::chrono::milliseconds Scale(std::chrono::milliseconds duration) const noexcept;
+
+    // A loopback TCP address no earlier run used, so sockets still closing
+    // never get in the way.
+    std::string NextAddress();
+
+    void Report(Result result);
+
+    [[nodiscard]] const std::vector<Result>& results() const noexcept {
+        return results_;
+    }
+
+private:
+    bool quick_;
+    std::uint16_t next_port_;
+    std::vector<Result> results_;
+};
+
+struct Benchmark {
+    std::string_view name;
+    std::string_view description;
+    void (*run)(Context& context);
+};
+
+std::vector<Benchmark> MeshBenchmarks();
+std::vector<Benchmark> ComponentBenchmarks();
+
+// Adds <prefix>_p50_us, _p99_us, _p999_us, _max_us and _mean_us.
+void AddLatency(Result& result, std::string_view prefix, const HistogramSnapshot& snapshot);
+
+void WriteJson(std::ostream& out, const Context& context);
+
+inline double Seconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double>(duration).count();
+}
+
+// Polls until done() holds; false if timeout passed first.
+template <typename Predicate>
+bool WaitFor(Predicate&& done, std::chrono::milliseconds timeout = std::chrono::seconds{60}) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds{200});
+    }
+    return true;
+}
+
+} // namespace minx::zmesh::benchmark
@@ -0,0 +1,265 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "minx/zmesh/bounded_queue.hpp"
+#include "minx/zmesh/compressor.hpp"
+#include "minx/zmesh/content_type.hpp"
+#include "minx/zmesh/mpsc_queue.hpp"
+#include "minx/zmesh/pending_request_table.hpp"
+#include "minx/zmesh/spsc_queue.hpp"
+#include "minx/zmesh/thread_safe_queue.hpp"
+#include "minx/zmesh/timer_wheel.hpp"
+#include "minx/zmesh/zmesh_options.hpp"
+
+namespace minx::zmesh::benchmark {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// The same push/try_pop surface over the queues the mesh chooses between,
+// default-constructed as the mesh does.
+template <typename Queue>
+struct QueueAdapter {
+    Queue queue;
+
+    void Push(std::uint64_t value) {
+        queue.push(value);
+    }
+    bool TryPop(std::uint64_t& value) {
+        return queue.try_pop(value);
+    }
+};
+
+// Full SpscQueue pushes fail instead of waiting.
+template <>
+struct QueueAdapter<SpscQueue<std::uint64_t>> {
+    SpscQueue<std::uint64_t> queue;
+
+    void Push(std::uint64_t value) {
+        while (!queue.try_push(value)) {
+            std::this_thread::yield();
+        }
+    }
+    bool TryPop(std::uint64_t& value) {
+        return queue.try_pop(value);
+    }
+};
+
+// Producers push items between them while this thread pops them all.
+template <typename Queue>
+double RunProducersConsumer(std::size_t producers, std::size_t items) {
+    QueueAdapter<Queue> adapter;
+    std::atomic<bool> start{false};
+    std::vector<std::jthread> threads;
+    const auto per_producer = items / producers;
+    for (std::size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&adapter, &start, per_producer] {
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (std::size_t i = 0; i < per_producer; ++i) {
+                adapter.Push(i);
+            }
+        });
+    }
+
+    const auto total = per_producer * producers;
+    const auto started = Clock::now();
+    start.store(true, std::memory_order_release);
+    std::uint64_t value = 0;
+    for (std::size_t popped = 0; popped < total;) {
+        if (adapter.TryPop(value)) {
+            ++popped;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    const auto elapsed = Seconds(Clock::now() - started);
+    threads.clear();
+    return static_cast<double>(total) / elapsed;
+}
+
+template <typename Queue>
+double RunPushPop(std::size_t items) {
+    QueueAdapter<Queue> adapter;
+    std::uint64_t value = 0;
+    const auto started = Clock::now();
+    for (std::size_t i = 0; i < items; ++i) {
+        adapter.Push(i);
+        if (!adapter.TryPop(value)) {
+            throw std::logic_error("queue lost an item");
+        }
+    }
+    return Seconds(Clock::now() - started) * 1e9 / static_cast<double>(items);
+}
+
+void QueuePushPop(Context& context) {
+    const auto items = context.Scale(std::size_t{2'000'000});
+    const auto report = [&context](const char* queue, double nanoseconds) {
+        context.Report(Result{.name = "queue_push_pop",
+                              .params = {{"queue", std::string(queue)}},
+                              .metrics = {{"ns_per_push_pop", nanoseconds}}});
+    };
+    report("ThreadSafeQueue", RunPushPop<ThreadSafeQueue<std::uint64_t>>(items));
+    report("MpscQueue", RunPushPop<MpscQueue<std::uint64_t>>(items));
+    report("BoundedQueue", RunPushPop<BoundedQueue<std::uint64_t>>(items));
+    report("SpscQueue", RunPushPop<SpscQueue<std::uint64_t>>(items));
+}
+
+void QueueContention(Context& context) {
+    const auto items = context.Scale(std::size_t{2'000'000});
+    for (const std::size_t producers : {1, 2, 4, 8, 16, 32}) {
+        const auto report = [&context, producers](const char* queue, double ops) {
+            context.Report(Result{.name = "queue_contention",
+                                  .params = {{"queue", std::string(queue)},
+                                             {"producers", static_cast<std::int64_t>(producers)}},
+                                  .metrics = {{"items_per_sec", ops}}});
+        };
+        report("ThreadSafeQueue", RunProducersConsumer<ThreadSafeQueue<std::uint64_t>>(producers, items));
+        report("MpscQueue", RunProducersConsumer<MpscQueue<std::uint64_t>>(producers, items));
+        report("BoundedQueue", RunProducersConsumer<BoundedQueue<std::uint64_t>>(producers, items));
+    }
+}
+
+// Every Ask with a timeout schedules a timer and nearly always cancels it.
+void TimerScheduleCancel(Context& context) {
+    const auto operations = context.Scale(std::size_t{1'000'000});
+    for (const std::size_t threads : {1, 4}) {
+        TimerWheel timers;
+        const auto per_thread = operations / threads;
+        const auto started = Clock::now();
+        {
+            std::vector<std::jthread> workers;
+            for (std::size_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&timers, per_thread] {
+                    for (std::size_t i = 0; i < per_thread; ++i) {
+                        const auto timer = timers.Schedule(std::chrono::seconds{30}, [] {});
+                        timers.Cancel(timer);
+                    }
+                });
+            }
+        }
+        const auto elapsed = Seconds(Clock::now() - started);
+        timers.Stop();
+        context.Report(Result{.name = "timer_schedule_cancel",
+                              .params = {{"threads", static_cast<std::int64_t>(threads)}},
+                              .metrics = {{"ops_per_sec", static_cast<double>(per_thread * threads) / elapsed}}});
+    }
+}
+
+// Insert and Take of the correlation table every Ask goes through.
+void PendingTableContention(Context& context) {
+    const auto operations = context.Scale(std::size_t{2'000'000});
+    for (const std::size_t threads : {1, 4, 16}) {
+        PendingRequestTable<std::uint64_t> table;
+        const auto per_thread = operations / threads;
+        const auto started = Clock::now();
+        {
+            std::vector<std::jthread> workers;
+            for (std::size_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&table, per_thread] {
+                    for (std::size_t i = 0; i < per_thread; ++i) {
+                        const auto id = table.Insert(i);
+                        (void)table.Take(id);
+                    }
+                });
+            }
+        }
+        const auto elapsed = Seconds(Clock::now() - started);
+        context.Report(Result{.name = "pending_table",
+                              .params = {{"threads", static_cast<std::int64_t>(threads)}},
+                              .metrics = {{"insert_take_per_sec",
+                                           static_cast<double>(per_thread * threads) / elapsed}}});
+    }
+}
+
+// JSON-ish records, about as compressible as typical message payloads.
+std::string CompressibleContent(std::size_t size) {
+    std::string content;
+    content.reserve(size + 128);
+    for (std::size_t i = 0; content.size() < size; ++i) {
+        content += "{\"id\":" + std::to_string(i * 7919 % 100003) + ",\"name\":\"item-" + std::to_string(i % 97) +
+                   "\",\"price\":" + std::to_string(i * 31 % 1000) + ".99,\"tags\":[\"a\",\"b\"]},";
+    }
+    content.resize(size);
+    return content;
+}
+
+void Compression(Context& context) {
+    struct Setting {
+        const char* name;
+        CompressionAlgorithm algorithm;
+        int level;
+    };
+    const auto budget = context.Scale(std::chrono::milliseconds{500});
+    for (const auto& setting : {Setting{"lz4", CompressionAlgorithm::Lz4, 0},
+                                Setting{"zstd-1", CompressionAlgorithm::Zstd, 1},
+                                Setting{"zstd-3", CompressionAlgorithm::Zstd, 3}}) {
+        const Compressor compressor({{"Bench",
+                                      CompressionOptions{.algorithm = setting.algorithm,
+                                                         .min_size = 0,
+                                                         .level = setting.level,
+                                                         .dictionary = nullptr}}});
+        const ContentType content_type("Bench");
+        for (const std::size_t size : {4096, 65536}) {
+            const auto content = CompressibleContent(size);
+            std::string compressed;
+            std::string decompressed;
+
+            std::uint16_t flags = 0;
+            std::size_t compress_runs = 0;
+            auto started = Clock::now();
+            while (Clock::now() - started < budget) {
+                compressed.clear();
+                flags = compressor.Compress(content_type, content, compressed);
+                ++compress_runs;
+            }
+            const auto compress_seconds = Seconds(Clock::now() - started);
+
+            std::size_t decompress_runs = 0;
+            started = Clock::now();
+            while (Clock::now() - started < budget) {
+                decompressed.clear();
+                if (!compressor.Decompress(content_type, flags, compressed, decompressed)) {
+                    throw std::runtime_error("decompression failed");
+                }
+                ++decompress_runs;
+            }
+            const auto decompress_seconds = Seconds(Clock::now() - started);
+
+            const auto megabytes = static_cast<double>(size) / 1e6;
+            context.Report(Result{
+                .name = "compression",
+                .params = {{"algorithm", std::string(setting.name)},
+                           {"payload_bytes", static_cast<std::int64_t>(size)}},
+                .metrics = {{"wire_bytes", static_cast<std::int64_t>(compressed.size())},
+                            {"ratio", static_cast<double>(size) / static_cast<double>(compressed.size())},
+                            {"compress_mb_per_sec", megabytes * static_cast<double>(compress_runs) / compress_seconds},
+                            {"decompress_mb_per_sec",
+                             megabytes * static_cast<double>(decompress_runs) / decompress_seconds}}});
+        }
+    }
+}
+
+} // namespace
+
+std::vector<Benchmark> ComponentBenchmarks() {
+    return {
+        {"queue_push_pop", "Uncontended push+pop of each queue type", QueuePushPop},
+        {"queue_contention", "1-32 producers into one consumer per queue type", QueueContention},
+        {"timer_schedule_cancel", "TimerWheel Schedule+Cancel pairs", TimerScheduleCancel},
+        {"pending_table", "PendingRequestTable Insert+Take from 1-16 threads", PendingTableContention},
+        {"compression", "Compressor ratio and MB/s for LZ4 and zstd", Compression},
+    };
+}
+
+} // namespace minx::zmesh::benchmark
@@ -0,0 +1,95 @@
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "benchmark.hpp"
+
+namespace {
+
+void PrintUsage() {
+    std::cerr << "usage: zmesh_benchmark [--filter SUBSTRING] [--out FILE] [--quick] [--port N] [--list]\n"
+                 "\n"
+                 "Runs loopback benchmarks of minx::zmesh and writes the results as JSON\n"
+                 "to FILE, or stdout. Progress goes to stderr. --quick cuts message counts\n"
+                 "and run times to a tenth, for smoke runs; --port is the first TCP port\n"
+                 "used (default 27100), one per mesh pair.\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    using namespace minx::zmesh::benchmark;
+
+    std::string filter;
+    std::string out_path;
+    bool quick = false;
+    bool list = false;
+    long port = 27100;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+        const bool has_value = i + 1 < argc;
+        if (arg == "--filter" && has_value) {
+            filter = argv[++i];
+        } else if (arg == "--out" && has_value) {
+            out_path = argv[++i];
+        } else if (arg == "--port" && has_value) {
+            port = std::strtol(argv[++i], nullptr, 10);
+        } else if (arg == "--quick") {
+            quick = true;
+        } else if (arg == "--list") {
+            list = true;
+        } else {
+            PrintUsage();
+            return arg == "--help" || arg == "-h" ? 0 : 2;
+        }
+    }
+    if (port <= 0 || port > 65535) {
+        std::cerr << "--port must be between 1 and 65535\n";
+        return 2;
+    }
+
+    std::vector<Benchmark> benchmarks = ComponentBenchmarks();
+    for (auto& benchmark : MeshBenchmarks()) {
+        benchmarks.push_back(benchmark);
+    }
+
+    if (list) {
+        for (const auto& benchmark : benchmarks) {
+            std::cout << benchmark.name << "\t" << benchmark.description << '\n';
+        }
+        return 0;
+    }
+
+    Context context(quick, static_cast<std::uint16_t>(port));
+    int failures = 0;
+    for (const auto& benchmark : benchmarks) {
+        if (!filter.empty() && benchmark.name.find(filter) == std::string_view::npos) {
+            continue;
+        }
+        std::cerr << "== " << benchmark.name << '\n';
+        try {
+            benchmark.run(context);
+        } catch (const std::exception& ex) {
+            // The remaining benchmarks still run; the exit code reports it.
+            std::cerr << benchmark.name << " failed: " << ex.what() << '\n';
+            ++failures;
+        }
+    }
+
+    if (out_path.empty()) {
+        WriteJson(std::cout, context);
+    } else {
+        std::ofstream out(out_path);
+        WriteJson(out, context);
+        if (!out) {
+            std::cerr << "could not write " << out_path << '\n';
+            return 1;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
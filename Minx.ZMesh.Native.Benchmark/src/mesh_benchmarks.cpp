@@ -0,0 +1,575 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include <zmq.hpp>
+
+#include "benchmark.hpp"
+#include "minx/zmesh/executor.hpp"
+#include "minx/zmesh/metrics.hpp"
+#include "minx/zmesh/payload.hpp"
+#include "minx/zmesh/zmesh.hpp"
+
+namespace minx::zmesh::benchmark {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct LoopbackOptions {
+    // Boxes hosted by the receiving mesh.
+    std::size_t boxes = 1;
+    // Bind address of the receiving mesh; empty picks the next TCP port.
+    std::string address;
+    ZMeshOptions receiver;
+    ZMeshOptions sender;
+    HandlerOptions handler;
+    // Busy work per received Tell.
+    std::chrono::nanoseconds handler_work{0};
+};
+
+// A receiving mesh hosting boxes Box0..BoxN-1 and a sending mesh that hosts
+// none, over one loopback endpoint. Every box counts "Bench" Tells and
+// completed "BenchStream" streams, echoes "Echo" questions and has been asked
+// once from the sender, so dealers are connected and on the binary wire
+// before anything is measured.
+class Loopback {
+public:
+    Loopback(Context& context, LoopbackOptions options)
+        : address_(options.address.empty() ? context.NextAddress() : options.address),
+          receiver_(address_, SystemMap(options.boxes), options.receiver),
+          sender_(std::nullopt, SystemMap(options.boxes), options.sender) {
+        for (std::size_t i = 0; i < options.boxes; ++i) {
+            const auto name = "Box" + std::to_string(i);
+            auto box = receiver_.At(name);
+            box->Listen(
+                "Bench",
+                [this, work = options.handler_work](std::string_view) {
+                    if (work.count() > 0) {
+                        const auto until = Clock::now() + work;
+                        while (Clock::now() < until) {
+                        }
+                    }
+                    received_.fetch_add(1, std::memory_order_relaxed);
+                },
+                options.handler);
+            box->ListenStream("BenchStream", [this](const StreamChunk& chunk) {
+                if (chunk.last) {
+                    streams_completed_.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+            box->Respond("Echo", [](std::string_view content) {
+                return Answer{.content_type = "Echo", .content = std::string(content)};
+            });
+            boxes_.push_back(sender_.At(name));
+        }
+        for (const auto& box : boxes_) {
+            box->Ask("Echo", "warm-up", std::chrono::seconds{30}).get();
+        }
+    }
+
+    [[nodiscard]] const std::vector<std::shared_ptr<IAbstractMessageBox>>& boxes() const noexcept {
+        return boxes_;
+    }
+
+    [[nodiscard]] std::size_t received() const noexcept {
+        return received_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::size_t streams_completed() const noexcept {
+        return streams_completed_.load(std::memory_order_relaxed);
+    }
+
+    // Producers Tell count messages between them, round-robin over the boxes,
+    // and the time until the last one is handled is returned.
+    double SendTells(const Payload& payload, std::size_t count, std::size_t producers = 1) {
+        const auto per_producer = count / producers;
+        const auto target = received() + per_producer * producers;
+        const auto started = Clock::now();
+        {
+            std::vector<std::jthread> threads;
+            for (std::size_t p = 0; p < producers; ++p) {
+                threads.emplace_back([this, &payload, per_producer, p] {
+                    for (std::size_t i = 0; i < per_producer; ++i) {
+                        boxes_[(p + i) % boxes_.size()]->Tell("Bench", payload);
+                    }
+                });
+            }
+        }
+        if (!WaitFor([this, target] { return received() >= target; })) {
+            throw std::runtime_error("only " + std::to_string(received()) + " of " + std::to_string(target) +
+                                     " Tells arrived");
+        }
+        return Seconds(Clock::now() - started);
+    }
+
+private:
+    std::unordered_map<std::string, std::string> SystemMap(std::size_t boxes) const {
+        std::unordered_map<std::string, std::string> system_map;
+        for (std::size_t i = 0; i < boxes; ++i) {
+            system_map.emplace("Box" + std::to_string(i), address_);
+        }
+        return system_map;
+    }
+
+    std::string address_;
+    // Declared before the meshes, whose handlers count into it.
+    std::atomic<std::size_t> received_{0};
+    std::atomic<std::size_t> streams_completed_{0};
+    ZMesh receiver_;
+    ZMesh sender_;
+    std::vector<std::shared_ptr<IAbstractMessageBox>> boxes_;
+};
+
+Payload MakePayload(std::size_t size) {
+    return Payload(std::string(size, 'x'));
+}
+
+void AddThroughput(Result& result, std::size_t messages, std::size_t payload_size, double seconds) {
+    const auto rate = static_cast<double>(messages) / seconds;
+    result.metrics.emplace_back("msgs_per_sec", rate);
+    result.metrics.emplace_back("mb_per_sec", rate * static_cast<double>(payload_size) / 1e6);
+    result.metrics.emplace_back("seconds", seconds);
+}
+
+// Closed-loop Asks from askers threads for duration; Ask RTT percentiles.
+HistogramSnapshot MeasureAsks(Loopback& loopback,
+                              Result& result,
+                              std::size_t askers,
+                              std::chrono::milliseconds duration,
+                              std::size_t payload_size = 64) {
+    LatencyHistogram rtt;
+    std::atomic<std::uint64_t> asks{0};
+    const auto payload = MakePayload(payload_size);
+    const auto started = Clock::now();
+    const auto deadline = started + duration;
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t a = 0; a < askers; ++a) {
+            threads.emplace_back([&, a] {
+                const auto& box = loopback.boxes()[a % loopback.boxes().size()];
+                while (Clock::now() < deadline) {
+                    const auto asked = Clock::now();
+                    box->Ask("Echo", payload, std::chrono::seconds{30}).get();
+                    rtt.Record(Clock::now() - asked);
+                    asks.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+    }
+    const auto seconds = Seconds(Clock::now() - started);
+    result.metrics.emplace_back("asks_per_sec", static_cast<double>(asks.load()) / seconds);
+    auto snapshot = rtt.Snapshot();
+    AddLatency(result, "rtt", snapshot);
+    return snapshot;
+}
+
+void TellThroughput(Context& context) {
+    for (const std::size_t size : {16, 256, 4096, 65536}) {
+        Loopback loopback(context, {});
+        const auto count = context.Scale(size <= 4096 ? std::size_t{200'000} : std::size_t{20'000});
+        const auto seconds = loopback.SendTells(MakePayload(size), count);
+        Result result{.name = "tell_throughput",
+                      .params = {{"payload_bytes", static_cast<std::int64_t>(size)}},
+                      .metrics = {}};
+        AddThroughput(result, count, size, seconds);
+        context.Report(std::move(result));
+    }
+}
+
+void AskLatency(Context& context) {
+    struct Load {
+        std::size_t askers;
+        bool background_tells;
+    };
+    for (const auto& load : {Load{1, false}, Load{8, false}, Load{32, false}, Load{8, true}}) {
+        Loopback loopback(context, {});
+        std::jthread background;
+        if (load.background_tells) {
+            // Keeps the same dealer and router busy with 256 byte Tells. At most
+            // 256 are in flight, so Asks wait behind load rather than a backlog.
+            background = std::jthread([&loopback](std::stop_token stop_token) {
+                const auto payload = MakePayload(256);
+                std::size_t sent = 0;
+                while (!stop_token.stop_requested()) {
+                    if (sent - loopback.received() >= 256) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    loopback.boxes()[0]->Tell("Bench", payload);
+                    ++sent;
+                }
+            });
+        }
+
+        Result result{.name = "ask_latency",
+                      .params = {{"askers", static_cast<std::int64_t>(load.askers)},
+                                 {"background_tells", std::int64_t{load.background_tells ? 1 : 0}}},
+                      .metrics = {}};
+        MeasureAsks(loopback, result, load.askers, context.Scale(std::chrono::milliseconds{3000}));
+        background = {};
+        context.Report(std::move(result));
+    }
+}
+
+// Fails unless one asker on an otherwise idle loopback mesh sees a p99 RTT
+// under a millisecond: answers must go out as soon as they are queued.
+void IdleAskRtt(Context& context) {
+    Loopback loopback(context, {});
+    Result result{.name = "idle_ask_rtt", .params = {}, .metrics = {}};
+    const auto rtt = MeasureAsks(loopback, result, 1, context.Scale(std::chrono::milliseconds{3000}));
+    context.Report(std::move(result));
+    const auto p99 = rtt.Percentile(99);
+    if (p99 >= std::chrono::milliseconds{1}) {
+        throw std::runtime_error("idle Ask p99 RTT is " + std::to_string(p99.count() / 1000) + " us, not under 1 ms");
+    }
+}
+
+// Fails unless the router forgets native dealers that went away: dealers
+// connect, Ask once and close, round after round, while the router keeps
+// greeting each new one. A dealer that stayed quiet through the churn must
+// still be answered afterwards.
+void PeerReconnect(Context& context) {
+    const auto address = context.NextAddress();
+    const std::unordered_map<std::string, std::string> system_map{{"Box0", address}};
+    ZMeshOptions receiver_options;
+    receiver_options.peer_idle_timeout = std::chrono::milliseconds{100};
+    ZMesh receiver(address, system_map, receiver_options);
+    receiver.At("Box0")->Respond("Echo", [](std::string_view content) {
+        return Answer{.content_type = "Echo", .content = std::string(content)};
+    });
+
+    ZMesh quiet(std::nullopt, system_map);
+    quiet.At("Box0")->Ask("Echo", "hello", std::chrono::seconds{30}).get();
+
+    const auto rounds = context.quick() ? std::size_t{20} : std::size_t{100};
+    std::size_t most_peers = 0;
+    const auto started = Clock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        {
+            ZMesh sender(std::nullopt, system_map);
+            sender.At("Box0")->Ask("Echo", "hello", std::chrono::seconds{30}).get();
+        }
+        most_peers = std::max(most_peers, receiver.GetMetrics().binary_peers);
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    }
+    const auto seconds = Seconds(Clock::now() - started);
+    quiet.At("Box0")->Ask("Echo", "hello again", std::chrono::seconds{30}).get();
+
+    Result result{.name = "peer_reconnect",
+                  .params = {{"rounds", static_cast<std::int64_t>(rounds)}},
+                  .metrics = {}};
+    result.metrics.emplace_back("most_binary_peers", static_cast<std::int64_t>(most_peers));
+    result.metrics.emplace_back("seconds", seconds);
+    context.Report(std::move(result));
+    // Two 100 ms generations of 20 ms rounds, with room for slow rounds.
+    if (most_peers > 16) {
+        throw std::runtime_error("router remembered " + std::to_string(most_peers) + " of " +
+                                 std::to_string(rounds + 1) + " dealers");
+    }
+}
+
+// Coroutine that runs up to its first co_await straight away and keeps its
+// frame at the end, so the caller decides when the frame is destroyed.
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_always final_suspend() noexcept {
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {}
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Holds resumptions until Run(), so frames can be destroyed in between.
+class QueuedExecutor final : public Executor {
+public:
+    void Post(Task task) override {
+        std::lock_guard lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+
+    void Run() {
+        std::vector<Task> tasks;
+        {
+            std::lock_guard lock(mutex_);
+            tasks.swap(tasks_);
+        }
+        for (auto& task : tasks) {
+            task();
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<Task> tasks_;
+};
+
+DetachedTask AskEcho(std::shared_ptr<IAbstractMessageBox> box,
+                     Executor* resume_on,
+                     std::atomic<std::size_t>& resumed) {
+    co_await box->AskAsync("Echo", "hello", AskOptions{.timeout = std::chrono::seconds{30}, .resume_on = resume_on});
+    resumed.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::size_t PendingAnswers(ZMesh& mesh) {
+    std::size_t pending = 0;
+    for (const auto& box : mesh.GetMetrics().message_boxes) {
+        pending += box.pending_answers;
+    }
+    return pending;
+}
+
+// Fails unless AskAsync coroutines destroyed while their answers arrive are
+// never resumed and leave no pending answers behind. Resumptions are queued
+// and run only after every frame of the batch is gone.
+void AskAsyncCancel(Context& context) {
+    const auto address = context.NextAddress();
+    const std::unordered_map<std::string, std::string> system_map{{"Box0", address}};
+    ZMesh receiver(address, system_map);
+    receiver.At("Box0")->Respond("Echo", [](std::string_view content) {
+        return Answer{.content_type = "Echo", .content = std::string(content)};
+    });
+    ZMesh sender(std::nullopt, system_map);
+    const auto box = sender.At("Box0");
+    box->Ask("Echo", "warm-up", std::chrono::seconds{30}).get();
+
+    QueuedExecutor resumes;
+    std::atomic<std::size_t> resumed{0};
+    constexpr std::size_t kBatch = 64;
+
+    // Left alone, a batch is answered and resumed in full.
+    std::vector<DetachedTask> tasks;
+    for (std::size_t i = 0; i < kBatch; ++i) {
+        tasks.push_back(AskEcho(box, &resumes, resumed));
+    }
+    const auto all_resumed = WaitFor([&] {
+        resumes.Run();
+        return resumed.load() == kBatch;
+    });
+    for (auto& task : tasks) {
+        task.handle.destroy();
+    }
+    tasks.clear();
+    if (!all_resumed) {
+        throw std::runtime_error("resumed " + std::to_string(resumed.load()) + " of " + std::to_string(kBatch) +
+                                 " AskAsync coroutines");
+    }
+
+    // Destroyed one by one as the answers land.
+    resumed = 0;
+    const auto rounds = context.Scale(std::size_t{2000});
+    const auto started = Clock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        for (std::size_t i = 0; i < kBatch; ++i) {
+            tasks.push_back(AskEcho(box, &resumes, resumed));
+        }
+        for (auto& task : tasks) {
+            task.handle.destroy();
+        }
+        tasks.clear();
+        resumes.Run();
+    }
+    const auto seconds = Seconds(Clock::now() - started);
+    const auto pending = PendingAnswers(sender);
+    box->Ask("Echo", "still answering", std::chrono::seconds{30}).get();
+
+    Result result{.name = "ask_async_cancel",
+                  .params = {{"rounds", static_cast<std::int64_t>(rounds)}},
+                  .metrics = {}};
+    result.metrics.emplace_back("seconds", seconds);
+    context.Report(std::move(result));
+    if (resumed.load() != 0) {
+        throw std::runtime_error(std::to_string(resumed.load()) + " destroyed AskAsync coroutines were resumed");
+    }
+    if (pending != 0) {
+        throw std::runtime_error(std::to_string(pending) + " answers left pending by destroyed AskAsync coroutines");
+    }
+}
+
+// Many threads Telling one box share its outgoing queue.
+void FanIn(Context& context) {
+    for (const auto queue_kind : {QueueKind::Locked, QueueKind::LockFree}) {
+        for (const std::size_t producers : {1, 4, 16, 32}) {
+            LoopbackOptions options;
+            options.sender.single_consumer_queue = queue_kind;
+            Loopback loopback(context, options);
+            const auto count = context.Scale(std::size_t{320'000});
+            const auto seconds = loopback.SendTells(MakePayload(256), count, producers);
+            Result result{.name = "fan_in",
+                          .params = {{"queue", std::string(queue_kind == QueueKind::Locked ? "Locked" : "LockFree")},
+                                     {"producers", static_cast<std::int64_t>(producers)}},
+                          .metrics = {}};
+            AddThroughput(result, count / producers * producers, 256, seconds);
+            context.Report(std::move(result));
+        }
+    }
+}
+
+// One dealer socket per remote box: setup cost and throughput as boxes grow.
+void ManyBoxes(Context& context) {
+    const std::vector<std::size_t> box_counts =
+        context.quick() ? std::vector<std::size_t>{16, 128} : std::vector<std::size_t>{16, 256, 1024};
+    for (const auto boxes : box_counts) {
+        LoopbackOptions options;
+        options.boxes = boxes;
+        options.sender.max_sockets = 4096;
+        options.receiver.max_sockets = 4096;
+        const auto setup_started = Clock::now();
+        Loopback loopback(context, options);
+        const auto setup_seconds = Seconds(Clock::now() - setup_started);
+
+        const auto count = context.Scale(std::size_t{200'000});
+        const auto seconds = loopback.SendTells(MakePayload(256), count);
+        Result result{.name = "many_boxes", .params = {{"boxes", static_cast<std::int64_t>(boxes)}}, .metrics = {}};
+        AddThroughput(result, count, 256, seconds);
+        result.metrics.emplace_back("setup_seconds", setup_seconds);
+        context.Report(std::move(result));
+    }
+}
+
+void RouterPipelineWorkers(Context& context) {
+    for (const std::size_t workers : {0, 1, 2, 4, 8}) {
+        LoopbackOptions options;
+        options.boxes = 8;
+        options.receiver.router_workers = workers;
+        Loopback loopback(context, options);
+        const auto count = context.Scale(std::size_t{200'000});
+        const auto seconds = loopback.SendTells(MakePayload(256), count, 4);
+        Result result{.name = "router_pipeline",
+                      .params = {{"router_workers", static_cast<std::int64_t>(workers)}},
+                      .metrics = {}};
+        AddThroughput(result, count / 4 * 4, 256, seconds);
+        context.Report(std::move(result));
+    }
+}
+
+void Transports(Context& context) {
+    const auto ipc_path = "ipc:///tmp/minx-zmesh-benchmark-" + std::to_string(::getpid()) + ".ipc";
+    for (const std::string transport : {"tcp", "ipc", "inproc"}) {
+        LoopbackOptions options;
+        if (transport == "ipc") {
+            options.address = ipc_path;
+        } else if (transport == "inproc") {
+            options.address = "inproc://minx-zmesh-benchmark";
+            options.receiver.context = std::make_shared<zmq::context_t>(1);
+            options.sender.context = options.receiver.context;
+        }
+        Loopback loopback(context, options);
+        const auto count = context.Scale(std::size_t{200'000});
+        const auto seconds = loopback.SendTells(MakePayload(256), count);
+        Result result{.name = "transport", .params = {{"transport", transport}}, .metrics = {}};
+        AddThroughput(result, count, 256, seconds);
+        MeasureAsks(loopback, result, 1, context.Scale(std::chrono::milliseconds{2000}));
+        context.Report(std::move(result));
+    }
+}
+
+void TellBatchingSizes(Context& context) {
+    for (const std::size_t size : {64, 512, 4096}) {
+        for (const bool batched : {false, true}) {
+            LoopbackOptions options;
+            if (batched) {
+                options.sender.tell_batching.max_messages = 64;
+            }
+            Loopback loopback(context, options);
+            const auto count = context.Scale(std::size_t{200'000});
+            const auto seconds = loopback.SendTells(MakePayload(size), count);
+            Result result{.name = "tell_batching",
+                          .params = {{"payload_bytes", static_cast<std::int64_t>(size)},
+                                     {"max_messages", std::int64_t{batched ? 64 : 0}}},
+                          .metrics = {}};
+            AddThroughput(result, count, size, seconds);
+            context.Report(std::move(result));
+        }
+    }
+}
+
+// Handlers that do about 5 us of work each, on a growing executor.
+void HandlerScaling(Context& context) {
+    for (const bool unordered : {false, true}) {
+        for (const std::size_t threads : {1, 2, 4}) {
+            LoopbackOptions options;
+            options.receiver.handler_threads = threads;
+            options.handler.unordered = unordered;
+            options.handler_work = std::chrono::microseconds{5};
+            Loopback loopback(context, options);
+            const auto count = context.Scale(std::size_t{100'000});
+            const auto seconds = loopback.SendTells(MakePayload(64), count);
+            Result result{.name = "handler_scaling",
+                          .params = {{"handler_threads", static_cast<std::int64_t>(threads)},
+                                     {"unordered", std::int64_t{unordered ? 1 : 0}}},
+                          .metrics = {}};
+            AddThroughput(result, count, 64, seconds);
+            context.Report(std::move(result));
+        }
+    }
+}
+
+void Streaming(Context& context) {
+    const auto total = context.Scale(std::size_t{256} << 20);
+    for (const std::size_t chunk_size : {64 * 1024, 256 * 1024}) {
+        for (const std::size_t window : {4, 16}) {
+            LoopbackOptions options;
+            options.sender.streams = StreamOptions{.chunk_size = chunk_size, .window = window};
+            Loopback loopback(context, options);
+
+            const auto started = Clock::now();
+            loopback.boxes()[0]->TellStream("BenchStream", MakePayload(total));
+            if (!WaitFor([&loopback] { return loopback.streams_completed() >= 1; })) {
+                throw std::runtime_error("stream did not complete");
+            }
+            const auto seconds = Seconds(Clock::now() - started);
+            Result result{.name = "streaming",
+                          .params = {{"chunk_bytes", static_cast<std::int64_t>(chunk_size)},
+                                     {"window", static_cast<std::int64_t>(window)},
+                                     {"stream_bytes", static_cast<std::int64_t>(total)}},
+                          .metrics = {}};
+            result.metrics.emplace_back("mb_per_sec", static_cast<double>(total) / 1e6 / seconds);
+            result.metrics.emplace_back("seconds", seconds);
+            context.Report(std::move(result));
+        }
+    }
+}
+
+} // namespace
+
+std::vector<Benchmark> MeshBenchmarks() {
+    return {
+        {"tell_throughput", "Tell msgs/s by payload size over TCP loopback", TellThroughput},
+        {"ask_latency", "Ask RTT percentiles with 1-32 askers, with and without Tell load", AskLatency},
+        {"idle_ask_rtt", "Check: p99 Ask RTT on an idle loopback mesh is under 1 ms", IdleAskRtt},
+        {"peer_reconnect", "Check: the router forgets native dealers that reconnected", PeerReconnect},
+        {"ask_async_cancel", "Check: destroying AskAsync coroutines mid-answer never resumes them", AskAsyncCancel},
+        {"fan_in", "1-32 threads Telling one box, per outgoing queue kind", FanIn},
+        {"many_boxes", "Setup time and Tell throughput across many remote boxes", ManyBoxes},
+        {"router_pipeline", "Tell throughput with 0-8 router pipeline workers", RouterPipelineWorkers},
+        {"transport", "Tell throughput and Ask RTT over tcp, ipc and inproc", Transports},
+        {"tell_batching", "Tell throughput with and without batching by payload size", TellBatchingSizes},
+        {"handler_scaling", "Busy Listen handlers on 1-4 executor threads", HandlerScaling},
+        {"streaming", "TellStream MB/s by chunk size and window", Streaming},
+    };
+}
+
+} // namespace minx::zmesh::benchmark
@@ -1,6 +1,7 @@
 #include <chrono>
 #include <future>
 #include <iostream>
+#include <string_view>
 #include <thread>
 #include <unordered_map>
 
@@ -17,15 +18,26 @@ int main() {
     minx::zmesh::ZMesh node_a{"127.0.0.1:7000", system_map};
     minx::zmesh::ZMesh node_b{"127.0.0.1:7001", system_map};
 
+    node_a.At("BoxA")->Listen("HelloMsg", [](std::string_view content) {
+        std::cout << "BoxA received Hello with content: " << content << '\n';
+    });
+
+    node_b.At("BoxB")->Listen("HelloMsg", [](std::string_view content) {
+        std::cout << "BoxB received Hello with content: " << content << '\n';
+    });
+
+    node_b.At("BoxB")->Respond("WhatIsYourName", [](std::string_view question_content) {
+        std::cout << "BoxB received question: " << question_content << '\n';
+        return minx::zmesh::Answer{
+            .content_type = "NameAnswer",
+            .content = "I am BoxB",
+        };
+    });
+
     std::jthread worker_a([&](std::stop_token stop_token) {
         while (!stop_token.stop_requested()) {
-            auto box_a = node_a.At("BoxA");
             auto box_b = node_a.At("BoxB");
 
-            box_a->TryListen("HelloMsg", [](const std::string& content) {
-                std::cout << "BoxA received Hello with content: " << content << '\n';
-            });
-
             box_b->Tell("HelloMsg", "Greetings from node A");
 
             auto answer_future = box_b->Ask("WhatIsYourName", "Node A is asking");
@@ -42,22 +54,7 @@ int main() {
 
     std::jthread worker_b([&](std::stop_token stop_token) {
         while (!stop_token.stop_requested()) {
-            auto box_a = node_b.At("BoxA");
-            auto box_b = node_b.At("BoxB");
-
-            box_b->TryListen("HelloMsg", [](const std::string& content) {
-                std::cout << "BoxB received Hello with content: " << content << '\n';
-            });
-
-            box_a->Tell("HelloMsg", "Greetings from node B");
-
-            box_b->TryAnswer("WhatIsYourName", [](const std::string& question_content) {
-                std::cout << "BoxB received question: " << question_content << '\n';
-                return minx::zmesh::Answer{
-                    .content_type = "NameAnswer",
-                    .content = "I am BoxB",
-                };
-            });
+            node_b.At("BoxA")->Tell("HelloMsg", "Greetings from node B");
 
             std::this_thread::sleep_for(1s);
         }
@@ -1,89 +1,228 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <future>
 #include <memory>
 #include <mutex>
 #include <optional>
-#include <random>
 #include <string>
-#include <thread>
-#include <unordered_map>
 #include <variant>
 #include <vector>
 
 #include <zmq.hpp>
 
+#include "bounded_queue.hpp"
+#include "compressor.hpp"
+#include "content_type.hpp"
+#include "error_handler.hpp"
+#include "frame_writer.hpp"
 #include "iabstract_message_box.hpp"
-#include "thread_safe_queue.hpp"
+#include "message_inbox.hpp"
+#include "metrics.hpp"
+#include "pending_request_table.hpp"
+#include "reactor.hpp"
+#include "scheduled_queue.hpp"
+#include "timer_wheel.hpp"
+#include "tracing.hpp"
+#include "wire_format.hpp"
 
 namespace minx::zmesh {
 
-class ZMesh;
-
+// Handle to a message box. Sending (Tell, Ask) goes to the box's address
+// through a dealer socket that is opened on first use, so a box that is only
+// received into never opens one. Receiving is delegated to the MessageInbox
+// the mesh keeps for the box's name. A local box, one whose address is the
+// mesh's own, is sent to through that inbox directly: messages are never
+// framed, and the outgoing queue and its limit are not used.
 class AbstractMessageBox : public IAbstractMessageBox, public std::enable_shared_from_this<AbstractMessageBox> {
 public:
     AbstractMessageBox(std::string name,
                        std::string address,
                        zmq::context_t& context,
-                       std::shared_ptr<AnswerQueue> answer_queue);
+                       Reactor& reactor,
+                       TimerWheel& timers,
+                       std::shared_ptr<MessageInbox> inbox,
+                       const Compressor& compressor,
+                       std::shared_ptr<FlightRecorder> recorder,
+                       QueueKind outgoing_queue_kind = QueueKind::Locked,
+                       QueueLimit outgoing_limit = {},
+                       TellBatching tell_batching = {},
+                       StreamOptions streams_options = {},
+                       bool local = false,
+                       ErrorHandler on_error = {});
     ~AbstractMessageBox() override;
 
-    void Tell(std::string content_type, std::string content) override;
-    bool TryListen(const std::string& content_type, const TellHandler& handler) override;
-
-    std::future<Answer> Ask(const std::string& content_type) override;
-    std::future<Answer> Ask(const std::string& content_type, std::string content) override;
-    std::future<Answer> Ask(const std::string& content_type, std::chrono::milliseconds timeout) override;
-    std::future<Answer> Ask(const std::string& content_type, std::string content, std::chrono::milliseconds timeout) override;
-
-    bool TryAnswer(const std::string& question_content_type, const QuestionHandler& handler) override;
-    std::optional<PendingQuestion> GetQuestion(const std::string& question_type) override;
-
-    void ReceiveTell(const TellMessage& message);
-    void ReceiveQuestion(const PendingQuestion& pending_question);
-    void ReceiveAnswer(const AnswerMessage& message);
+    void Tell(ContentType content_type, std::string content) override;
+    void Tell(ContentType content_type, Payload content) override;
+    void TellStream(ContentType content_type, Payload content) override;
+    void TellStream(ContentType content_type, StreamSource source) override;
+    void ListenStream(ContentType content_type, TellStreamHandler handler) override;
+    void Listen(ContentType content_type, TellViewHandler handler, HandlerOptions options = {}) override;
+    void Respond(ContentType question_content_type,
+                 QuestionViewHandler handler,
+                 HandlerOptions options = {}) override;
+
+    bool TryListen(ContentType content_type, const TellHandler& handler) override;
+    bool TryListenView(ContentType content_type, const TellViewHandler& handler) override;
+    std::size_t TryListenBatch(ContentType content_type,
+                               std::size_t max_messages,
+                               const TellBatchHandler& handler) override;
+
+    std::future<Answer> Ask(ContentType content_type) override;
+    std::future<Answer> Ask(ContentType content_type, std::string content) override;
+    std::future<Answer> Ask(ContentType content_type, std::chrono::milliseconds timeout) override;
+    std::future<Answer> Ask(ContentType content_type, std::string content, std::chrono::milliseconds timeout) override;
+    std::future<Answer> Ask(ContentType content_type, Payload content) override;
+    std::future<Answer> Ask(ContentType content_type, Payload content, std::chrono::milliseconds timeout) override;
+
+    using IAbstractMessageBox::AskAsync;
+    AskAwaitable AskAsync(ContentType content_type, Payload content, AskOptions options = {}) override;
+
+    bool TryAnswer(ContentType question_content_type, const QuestionHandler& handler) override;
+    bool TryAnswerView(ContentType question_content_type, const QuestionViewHandler& handler) override;
+    std::size_t TryAnswerBatch(ContentType question_content_type,
+                               std::size_t max_questions,
+                               const QuestionBatchHandler& handler) override;
+    std::optional<PendingQuestion> GetQuestion(ContentType question_type) override;
+
+    void SetInboxLimit(QueueLimit limit) override;
+    void SetInboxLimit(ContentType content_type, QueueLimit limit) override;
+    QueueCounters GetInboxCounters(ContentType content_type) override;
+    QueueCounters GetOutgoingCounters() override;
+
+    void ReceiveAnswer(AnswerMessage message);
+
+    MessageBoxMetrics GetMetrics();
 
 private:
-    using OutgoingMessage = std::variant<TellMessage, QuestionMessage>;
-
-    std::shared_ptr<ThreadSafeQueue<std::string>> GetOrCreateMessageQueue(const std::string& content_type);
-    std::shared_ptr<ThreadSafeQueue<PendingQuestion>> GetOrCreatePendingQueue(const std::string& content_type);
-
-    std::future<Answer> InternalAsk(const std::string& content_type,
-                                    std::optional<std::string> content,
+    using OutgoingMessage = std::variant<TellMessage, QuestionMessage, StreamMessage>;
+
+    struct QueuedMessage {
+        OutgoingMessage message;
+        std::chrono::steady_clock::time_point enqueued_at;
+    };
+
+    friend class AskAwaitable;
+
+    // A stream being sent. next is pulled one chunk ahead, so the last chunk
+    // can be flagged as such; credits is the room left in its window.
+    struct OutgoingStream {
+        CorrelationId id{0};
+        ContentType content_type;
+        StreamSource source;
+        Payload next;
+        std::size_t credits{0};
+    };
+
+    // Completed through exactly one of promise (Ask) or awaiter (AskAsync). An
+    // awaiter destroyed first takes its entry out through CancelAsk().
+    struct PendingAnswer {
+        std::shared_ptr<std::promise<Answer>> promise{};
+        std::shared_ptr<AskAwaitable::State> awaiter{};
+        TimerWheel::TimerId timeout_timer{TimerWheel::kInvalidTimer};
+        std::chrono::steady_clock::time_point asked_at{};
+        TraceId trace_id{0};
+
+        void Resolve(Answer answer);
+        void Reject(std::exception_ptr error);
+    };
+
+    std::future<Answer> InternalAsk(ContentType content_type,
+                                    Payload content,
                                     std::optional<std::chrono::milliseconds> timeout);
-
-    void DealerLoop(std::stop_token stop_token);
+    void StartAsk(AskAwaitable& awaiter);
+    // Drops a pending Ask, and its timeout, without completing it.
+    void CancelAsk(CorrelationId correlation_id);
+    void SendQuestion(PendingAnswer pending_answer,
+                      ContentType content_type,
+                      Payload content,
+                      std::optional<std::chrono::milliseconds> timeout);
+
+    void OpenDealer();
+    // The reactor closed the dealer after its handler threw.
+    void FailDealer(std::exception_ptr error);
+    PushResult EnqueueOutgoing(OutgoingMessage& message);
+    void ThrowIfNotQueued(PushResult result) const;
+    void FlushOutgoing(zmq::socket_t& dealer);
+    // Puts frames_ on the wire; false, with POLLOUT armed, if the dealer is full.
+    bool SendFrames(zmq::socket_t& dealer);
+    // False if the Tell has to be sent on its own.
+    bool BatchTell(const TellMessage& message);
+    // SendBatch, SendMessage and SendChunk add a message to frames_.
+    void SendBatch();
+    void ReceiveFromDealer(zmq::socket_t& dealer);
     void SendMessage(const TellMessage& message);
     void SendMessage(const QuestionMessage& message);
-    void SendAnswer(const PendingQuestion& pending_question, const Answer& answer);
-
-    std::string GenerateCorrelationId();
-
-    void FulfillPendingAnswer(const std::string& correlation_id, const Answer& answer);
-    void FailPendingAnswer(const std::string& correlation_id, std::exception_ptr error);
+    // Sets hello_deadline_ once a text message has gone out.
+    void ExpectHello();
+    // Starts sending the stream; chunks go out from PumpStreams. While a
+    // Hello is expected the stream waits in waiting_streams_.
+    void SendMessage(StreamMessage& message);
+    // Starts the streams that waited for the wire format, once it is known or
+    // the Hello is overdue.
+    void ReleaseWaitingStreams();
+    void PumpStreams(zmq::socket_t& dealer);
+    // aborted ends the stream with an empty last chunk after its source threw.
+    void SendChunk(const OutgoingStream& stream, const Payload& chunk, bool last, bool aborted = false);
+    void ReceiveCredit(zmq::socket_t& dealer, CorrelationId stream_id);
+    // The content to send and, in flags, how it was compressed.
+    Payload Compress(ContentType content_type, const Payload& content, std::uint16_t& flags) const;
+
+    void FulfillPendingAnswer(CorrelationId correlation_id, Answer answer);
+    void FailPendingAnswer(CorrelationId correlation_id, std::exception_ptr error, bool timed_out = false);
 
     std::string name_;
     std::string address_;
     zmq::context_t& context_;
-    std::shared_ptr<AnswerQueue> answer_queue_;
-
-    ThreadSafeQueue<OutgoingMessage> outgoing_messages_;
-    zmq::socket_t dealer_;
-    std::jthread dealer_thread_;
-
-    std::mutex messages_mutex_;
-    std::unordered_map<std::string, std::shared_ptr<ThreadSafeQueue<std::string>>> messages_;
-
-    std::mutex pending_questions_mutex_;
-    std::unordered_map<std::string, std::shared_ptr<ThreadSafeQueue<PendingQuestion>>> pending_questions_;
-
-    std::mutex pending_answers_mutex_;
-    std::unordered_map<std::string, std::shared_ptr<std::promise<Answer>>> pending_answers_;
-
-    std::mutex random_mutex_;
-    std::mt19937_64 random_engine_;
+    Reactor& reactor_;
+    TimerWheel& timers_;
+    std::shared_ptr<MessageInbox> inbox_;
+    const Compressor& compressor_;
+    std::shared_ptr<FlightRecorder> recorder_;
+    const bool local_;
+    // Stream sources that throw are reported here.
+    const ErrorHandler on_error_;
+
+    ScheduledQueue<QueuedMessage> outgoing_messages_;
+    std::once_flag dealer_opened_;
+    std::optional<Reactor::ChannelId> dealer_channel_;
+    // Only touched from the reactor thread that owns the dealer.
+    WireFormat wire_format_{WireFormat::Text};
+    // Messages taken off the queue that the dealer has not accepted yet; at
+    // most a batch and the message behind it. Reactor thread only.
+    FrameWriter frames_;
+
+    const TellBatching tell_batching_;
+    // Tells packed since the last batch went out; reactor thread only.
+    std::string batch_records_;
+    std::size_t batch_count_{0};
+    std::chrono::steady_clock::time_point batch_deadline_;
+
+    const StreamOptions streams_options_;
+    // Streams being sent; reactor thread only.
+    std::vector<OutgoingStream> streams_;
+    // Streams popped before the peer identified as native, and the point after
+    // which it is taken for a text peer; reactor thread only.
+    std::vector<StreamMessage> waiting_streams_;
+    std::optional<std::chrono::steady_clock::time_point> hello_deadline_;
+    bool text_peer_{false};
+
+    PendingRequestTable<PendingAnswer> pending_answers_;
+
+    // Relaxed counters behind GetMetrics().
+    std::atomic<std::uint64_t> tells_sent_{0};
+    std::atomic<std::uint64_t> questions_sent_{0};
+    std::atomic<std::uint64_t> streams_sent_{0};
+    std::atomic<std::uint64_t> chunks_sent_{0};
+    std::atomic<std::uint64_t> answers_received_{0};
+    std::atomic<std::uint64_t> asks_timed_out_{0};
+    std::atomic<std::uint64_t> asks_failed_{0};
+    std::atomic<std::size_t> outgoing_depth_{0};
+    LatencyHistogram ask_rtt_;
+    LatencyHistogram enqueue_to_send_;
 };
 
 } // namespace minx::zmesh
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "scheduled_queue.hpp"
+#include "types.hpp"
+
+namespace minx::zmesh {
+
+// Answers produced by message box handlers, waiting to be sent by the
+// router channel. Every push schedules a flush of the router on the reactor.
+using AnswerQueue = ScheduledQueue<IdentityMessage<AnswerMessage>>;
+
+} // namespace minx::zmesh
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "content_type.hpp"
+#include "executor.hpp"
+#include "payload.hpp"
+#include "types.hpp"
+
+namespace minx::zmesh {
+
+class AbstractMessageBox;
+
+struct AskOptions {
+    std::optional<std::chrono::milliseconds> timeout;
+
+    // Scheduler hook: where the awaiting coroutine is resumed. When null it is
+    // resumed directly on the thread that completes the Ask (a reactor thread
+    // for answers, the handler's thread for answers from a local box, the
+    // timer thread for timeouts), so it must not block.
+    Executor* resume_on = nullptr;
+};
+
+// Result of AskAsync(). Nothing is sent until it is co_awaited; the question
+// then goes out and the coroutine is resumed with the answer, a timeout or a
+// disposal error. The awaiter lives in the coroutine frame; the Ask completes
+// into a small state it shares with the pending-answer entry, so an answer
+// that races the coroutine's destruction never touches the frame. Destroying
+// a coroutine suspended on it withdraws the Ask: its answer or timeout is
+// ignored when it comes. The coroutine must not be destroyed while another
+// thread is resuming it.
+class AskAwaitable {
+public:
+    AskAwaitable(std::shared_ptr<AbstractMessageBox> message_box,
+                 ContentType content_type,
+                 Payload content,
+                 AskOptions options);
+    ~AskAwaitable();
+
+    AskAwaitable(const AskAwaitable&) = delete;
+    AskAwaitable& operator=(const AskAwaitable&) = delete;
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+    Answer await_resume();
+
+private:
+    friend class AbstractMessageBox;
+
+    // Where the Ask completes. The completing thread claims it, writes the
+    // result and only then resumes the coroutine, unless the awaiter has
+    // cancelled it first; the awaiter can cancel at any point before that.
+    class State : public std::enable_shared_from_this<State> {
+    public:
+        State(std::coroutine_handle<> handle, Executor* resume_on)
+            : handle_(handle),
+              resume_on_(resume_on) {}
+
+        void Resolve(Answer answer);
+        void Reject(std::exception_ptr error);
+        // False once the coroutine is being resumed.
+        bool Cancel() noexcept;
+
+        // The pending-answer entry's id; 0 until it is inserted.
+        std::atomic<CorrelationId> correlation_id{0};
+        std::optional<Answer> answer;
+        std::exception_ptr error;
+
+    private:
+        enum class Status : std::uint8_t { Pending, Completing, Ready, Resumed, Cancelled };
+
+        template <typename Write>
+        void Complete(Write&& write);
+        void Resume();
+
+        std::atomic<Status> status_{Status::Pending};
+        const std::coroutine_handle<> handle_;
+        Executor* const resume_on_;
+    };
+
+    std::shared_ptr<AbstractMessageBox> message_box_;
+    ContentType content_type_;
+    Payload content_;
+    AskOptions options_;
+
+    // The box asked, so the destructor can withdraw the Ask, and the state the
+    // Ask completes into; both set once awaited.
+    std::weak_ptr<AbstractMessageBox> asked_box_;
+    std::shared_ptr<State> state_;
+};
+
+} // namespace minx::zmesh
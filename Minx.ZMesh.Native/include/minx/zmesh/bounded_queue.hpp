@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace minx::zmesh {
+
+// What a full queue does with one more item.
+enum class OverflowPolicy : std::uint8_t {
+    // Wait until the consumer makes room.
+    Block,
+    // Evict the oldest queued item to make room.
+    DropOldest,
+    // Discard the new item.
+    DropNewest,
+    // Refuse the new item and report it to the producer. Questions an inbox
+    // refuses or drops under any policy are answered with an error; refused
+    // outgoing messages throw or fail the Ask.
+    Reject
+};
+
+struct QueueLimit {
+    // Maximum number of queued items; 0 means unbounded.
+    std::size_t capacity = 0;
+    OverflowPolicy policy = OverflowPolicy::Block;
+};
+
+struct QueueCounters {
+    std::uint64_t pushed = 0;
+    // Pushes that had to wait for room under OverflowPolicy::Block.
+    std::uint64_t blocked = 0;
+    std::uint64_t dropped_oldest = 0;
+    std::uint64_t dropped_newest = 0;
+    std::uint64_t rejected = 0;
+
+    QueueCounters& operator+=(const QueueCounters& other) noexcept {
+        pushed += other.pushed;
+        blocked += other.blocked;
+        dropped_oldest += other.dropped_oldest;
+        dropped_newest += other.dropped_newest;
+        rejected += other.rejected;
+        return *this;
+    }
+};
+
+enum class PushResult : std::uint8_t {
+    Pushed,
+    // The item was queued; the evicted oldest item is handed back.
+    DroppedOldest,
+    // The item was not queued.
+    DroppedNewest,
+    Rejected,
+    Closed
+};
+
+// Ring buffer queue with the try_pop/drain_into/wait_pop/close contract of
+// ThreadSafeQueue. With a capacity the ring is allocated once up front and
+// full pushes follow the overflow policy; without one it doubles as needed.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(QueueLimit limit = {}) {
+        set_limit(limit);
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // On return value holds whatever did not end up queued: nothing useful
+    // when Pushed, the evicted item when DroppedOldest, and the pushed item
+    // itself otherwise.
+    PushResult push(T& value) {
+        std::unique_lock lock(mutex_);
+        if (closed_) {
+            return PushResult::Closed;
+        }
+
+        if (limit_.capacity != 0 && size_ >= limit_.capacity) {
+            switch (limit_.policy) {
+            case OverflowPolicy::Block:
+                ++counters_.blocked;
+                not_full_.wait(lock, [this] { return closed_ || limit_.capacity == 0 || size_ < limit_.capacity; });
+                if (closed_) {
+                    return PushResult::Closed;
+                }
+                break;
+            case OverflowPolicy::DropOldest: {
+                ++counters_.dropped_oldest;
+                T oldest;
+                PopFront(oldest);
+                ring_[Index(size_)] = std::move(value);
+                ++size_;
+                ++counters_.pushed;
+                value = std::move(oldest);
+                return PushResult::DroppedOldest;
+            }
+            case OverflowPolicy::DropNewest:
+                ++counters_.dropped_newest;
+                return PushResult::DroppedNewest;
+            case OverflowPolicy::Reject:
+                ++counters_.rejected;
+                return PushResult::Rejected;
+            }
+        }
+
+        if (size_ == ring_.size()) {
+            Grow(std::max<std::size_t>(ring_.size() * 2, 16));
+        }
+        ring_[Index(size_)] = std::move(value);
+        ++size_;
+        ++counters_.pushed;
+        lock.unlock();
+        not_empty_.notify_one();
+        return PushResult::Pushed;
+    }
+
+    PushResult push(T&& value) {
+        return push(value);
+    }
+
+    [[nodiscard]] bool try_pop(T& value) {
+        {
+            std::lock_guard lock(mutex_);
+            if (size_ == 0) {
+                return false;
+            }
+            PopFront(value);
+        }
+        not_full_.notify_one();
+        return true;
+    }
+
+    // Moves up to max_items from the front into out under a single lock.
+    std::size_t drain_into(std::vector<T>& out, std::size_t max_items) {
+        std::size_t count;
+        {
+            std::lock_guard lock(mutex_);
+            count = std::min(max_items, size_);
+            out.reserve(out.size() + count);
+            for (std::size_t i = 0; i < count; ++i) {
+                PopFront(out.emplace_back());
+            }
+        }
+        if (count != 0) {
+            not_full_.notify_all();
+        }
+        return count;
+    }
+
+    template <typename Rep, typename Period>
+    [[nodiscard]] bool wait_pop(T& value, const std::chrono::duration<Rep, Period>& timeout) {
+        {
+            std::unique_lock lock(mutex_);
+            if (!not_empty_.wait_for(lock, timeout, [this] { return closed_ || size_ != 0; })) {
+                return false;
+            }
+            if (size_ == 0) {
+                return false;
+            }
+            PopFront(value);
+        }
+        not_full_.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard lock(mutex_);
+            closed_ = true;
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    [[nodiscard]] bool empty() const {
+        std::lock_guard lock(mutex_);
+        return size_ == 0;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        std::lock_guard lock(mutex_);
+        return size_;
+    }
+
+    // Items already queued beyond a lowered capacity stay queued; the policy
+    // applies to later pushes.
+    void set_limit(QueueLimit limit) {
+        {
+            std::lock_guard lock(mutex_);
+            limit_ = limit;
+            if (limit_.capacity > ring_.size()) {
+                Grow(limit_.capacity);
+            }
+        }
+        not_full_.notify_all();
+    }
+
+    [[nodiscard]] QueueCounters counters() const {
+        std::lock_guard lock(mutex_);
+        return counters_;
+    }
+
+private:
+    std::size_t Index(std::size_t offset) const noexcept {
+        return (head_ + offset) % ring_.size();
+    }
+
+    std::size_t Next(std::size_t index) const noexcept {
+        return index + 1 == ring_.size() ? 0 : index + 1;
+    }
+
+    void PopFront(T& value) {
+        value = std::move(ring_[head_]);
+        ring_[head_] = T{};
+        head_ = Next(head_);
+        --size_;
+    }
+
+    void Grow(std::size_t capacity) {
+        std::vector<T> ring(capacity);
+        for (std::size_t i = 0; i < size_; ++i) {
+            ring[i] = std::move(ring_[Index(i)]);
+        }
+        ring_ = std::move(ring);
+        head_ = 0;
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::vector<T> ring_;
+    std::size_t head_{0};
+    std::size_t size_{0};
+    QueueLimit limit_;
+    QueueCounters counters_;
+    bool closed_{false};
+};
+
+} // namespace minx::zmesh
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "content_type.hpp"
+#include "content_type_map.hpp"
+#include "zmesh_options.hpp"
+
+namespace minx::zmesh {
+
+// Applies ZMeshOptions::compression to payloads on the binary wire. A
+// compressed content frame is [original size:4 LE][compressed bytes], flagged
+// in the header with kWireFlagLz4 or kWireFlagZstd. Safe to use from any
+// thread; zstd contexts are kept per thread.
+class Compressor {
+public:
+    explicit Compressor(const std::unordered_map<std::string, CompressionOptions>& options);
+    ~Compressor();
+
+    Compressor(const Compressor&) = delete;
+    Compressor& operator=(const Compressor&) = delete;
+
+    // Whether Compress would try to compress content of this size.
+    [[nodiscard]] bool Compresses(ContentType content_type, std::size_t size) const noexcept;
+
+    // Writes the compressed frame to out and returns the header flag to send
+    // it with, or 0 if content is to be sent as it is.
+    std::uint16_t Compress(ContentType content_type, std::string_view content, std::string& out) const;
+
+    // Reverses Compress for a frame received with flags. Returns false if the
+    // frame is corrupt or needs a dictionary this side does not have.
+    bool Decompress(ContentType content_type, std::uint16_t flags, std::string_view frame, std::string& out) const;
+
+private:
+    struct Codec;
+
+    ContentTypeMap<Codec> codecs_;
+};
+
+} // namespace minx::zmesh
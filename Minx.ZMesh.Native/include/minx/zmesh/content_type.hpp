@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace minx::zmesh {
+
+using ContentTypeId = std::uint32_t;
+
+// Interned content type name. Constructing one looks the name up in a
+// process-wide table without taking a lock (only the first sighting of a name
+// does); afterwards the id keys per-box inboxes and codecs. Ids are dense,
+// start at 0 for the empty name and are only meaningful inside this process.
+// Keep frequently used content types in a static to skip the lookup entirely.
+// Names that arrive from peers go through Find or FromPeer instead, so peers
+// cannot grow the table without bound.
+class ContentType {
+public:
+    ContentType() noexcept;
+    ContentType(std::string_view name);
+    ContentType(const std::string& name)
+        : ContentType(std::string_view(name)) {}
+    ContentType(const char* name)
+        : ContentType(std::string_view(name)) {}
+
+    // The content type of a name this process has already interned, without
+    // interning it.
+    [[nodiscard]] static std::optional<ContentType> Find(std::string_view name) noexcept;
+    // Like Find, but also interns a new name while fewer than
+    // kMaxPeerContentTypes names have been interned against interned, the
+    // count of one mesh, so one mesh's peers cannot use up another's budget.
+    [[nodiscard]] static std::optional<ContentType> FromPeer(std::string_view name,
+                                                             std::atomic<std::size_t>& interned);
+
+    static constexpr std::size_t kMaxPeerContentTypes = 4096;
+
+    [[nodiscard]] ContentTypeId id() const noexcept { return entry_->id; }
+    [[nodiscard]] const std::string& name() const noexcept { return entry_->name; }
+
+    friend bool operator==(const ContentType& lhs, const ContentType& rhs) noexcept {
+        return lhs.entry_ == rhs.entry_;
+    }
+
+private:
+    friend class ContentTypeRegistry;
+
+    struct Entry {
+        std::string name;
+        ContentTypeId id;
+        std::size_t hash;
+    };
+
+    explicit ContentType(const Entry* entry) noexcept
+        : entry_(entry) {}
+
+    const Entry* entry_;
+};
+
+} // namespace minx::zmesh
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "content_type.hpp"
+
+namespace minx::zmesh {
+
+// Per-content-type values keyed by ContentTypeId, sized by the values the map
+// holds rather than by the process-wide ids. Lookups probe a published
+// open-addressed table without locking; creating a value takes a mutex and,
+// once the table is half full, publishes one twice the size. Values live until
+// the map is destroyed and superseded tables, together smaller than the current
+// one, are kept alongside them, so a pointer returned by Find or GetOrCreate
+// stays valid for the map's lifetime.
+template <typename T>
+class ContentTypeMap {
+public:
+    ContentTypeMap() = default;
+
+    ContentTypeMap(const ContentTypeMap&) = delete;
+    ContentTypeMap& operator=(const ContentTypeMap&) = delete;
+
+    [[nodiscard]] T* Find(ContentTypeId id) const noexcept {
+        const auto* table = table_.load(std::memory_order_acquire);
+        if (table == nullptr) {
+            return nullptr;
+        }
+        for (auto index = Slot(id, table->mask);; index = (index + 1) & table->mask) {
+            auto* node = table->slots[index].load(std::memory_order_acquire);
+            if (node == nullptr) {
+                return nullptr;
+            }
+            if (node->id == id) {
+                return &node->value;
+            }
+        }
+    }
+
+    // Constructs the value from args if the id has none yet.
+    template <typename... Args>
+    T& GetOrCreate(ContentTypeId id, Args&&... args) {
+        if (auto* value = Find(id)) {
+            return *value;
+        }
+
+        std::lock_guard lock(mutex_);
+        if (auto* value = Find(id)) {
+            return *value;
+        }
+
+        auto* table = table_.load(std::memory_order_relaxed);
+        if (table == nullptr || (nodes_.size() + 1) * 2 > table->mask + 1) {
+            table = Grow(table);
+        }
+        auto* node = nodes_.emplace_back(std::make_unique<Node>(id, std::forward<Args>(args)...)).get();
+        Insert(*table, node);
+        return node->value;
+    }
+
+    // Visits every value created so far; creation waits until it returns.
+    template <typename Fn>
+    void ForEach(Fn&& fn) {
+        std::lock_guard lock(mutex_);
+        for (auto& node : nodes_) {
+            fn(node->value);
+        }
+    }
+
+private:
+    struct Node {
+        template <typename... Args>
+        explicit Node(ContentTypeId node_id, Args&&... args)
+            : id(node_id),
+              value(std::forward<Args>(args)...) {}
+
+        const ContentTypeId id;
+        T value;
+    };
+
+    struct Table {
+        std::size_t mask;
+        std::unique_ptr<std::atomic<Node*>[]> slots;
+    };
+
+    // Ids are dense process-wide; multiplying spreads one map's subset of them.
+    static std::size_t Slot(ContentTypeId id, std::size_t mask) noexcept {
+        return static_cast<std::size_t>(id * 0x9E3779B1u) & mask;
+    }
+
+    static void Insert(Table& table, Node* node) noexcept {
+        auto index = Slot(node->id, table.mask);
+        while (table.slots[index].load(std::memory_order_relaxed) != nullptr) {
+            index = (index + 1) & table.mask;
+        }
+        table.slots[index].store(node, std::memory_order_release);
+    }
+
+    Table* Grow(const Table* table) {
+        const auto capacity = table == nullptr ? std::size_t{8} : (table->mask + 1) * 2;
+        auto grown = std::make_unique<Table>(
+            Table{.mask = capacity - 1, .slots = std::make_unique<std::atomic<Node*>[]>(capacity)});
+        for (auto& node : nodes_) {
+            Insert(*grown, node.get());
+        }
+
+        auto* published = grown.get();
+        tables_.push_back(std::move(grown));
+        table_.store(published, std::memory_order_release);
+        return published;
+    }
+
+    std::atomic<Table*> table_{nullptr};
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Node>> nodes_;
+    std::vector<std::unique_ptr<Table>> tables_;
+};
+
+} // namespace minx::zmesh
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace minx::zmesh {
+
+// Turns a bind address or system map entry into a ZeroMQ endpoint. Full URIs
+// (tcp://, ipc://, inproc://, ...) are used as given; a bare host:port is TCP.
+//
+// inproc:// endpoints only connect sockets of the same zmq::context_t, so
+// meshes talking over them must share one through ZMeshOptions::context.
+inline std::string ToEndpoint(std::string_view address) {
+    if (address.find("://") != std::string_view::npos) {
+        return std::string(address);
+    }
+    return "tcp://" + std::string(address);
+}
+
+} // namespace minx::zmesh
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <exception>
+#include <functional>
+
+namespace minx::zmesh {
+
+// Receives exceptions that have no caller to propagate to, such as a reactor
+// channel failing on its socket. It runs on the thread that caught the
+// exception and must not throw.
+using ErrorHandler = std::function<void(std::exception_ptr)>;
+
+// Passes error to on_error or, when there is none, writes it to stderr.
+void ReportError(const ErrorHandler& on_error, std::exception_ptr error) noexcept;
+
+} // namespace minx::zmesh
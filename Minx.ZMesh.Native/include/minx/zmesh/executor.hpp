@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "error_handler.hpp"
+
+namespace minx::zmesh {
+
+// Runs message box handlers registered with Listen()/Respond(). A task that
+// throws is reported through ReportError() and the executor carries on.
+class Executor {
+public:
+    using Task = std::function<void()>;
+
+    virtual ~Executor() = default;
+
+    virtual void Post(Task task) = 0;
+
+    // Passes an exception that escaped a task to the executor's ErrorHandler
+    // or, without one, writes it to stderr.
+    void ReportError(std::exception_ptr error) const noexcept {
+        minx::zmesh::ReportError(on_error_, std::move(error));
+    }
+
+protected:
+    explicit Executor(ErrorHandler on_error = {})
+        : on_error_(std::move(on_error)) {}
+
+private:
+    ErrorHandler on_error_;
+};
+
+// Runs every task on the posting thread, i.e. the reactor thread that received
+// the message. Only suitable for handlers that never block.
+class InlineExecutor final : public Executor {
+public:
+    explicit InlineExecutor(ErrorHandler on_error = {})
+        : Executor(std::move(on_error)) {}
+
+    void Post(Task task) override {
+        // Must not reach the reactor, which would close the socket over it.
+        try {
+            task();
+        } catch (...) {
+            ReportError(std::current_exception());
+        }
+    }
+};
+
+// Fixed pool of threads sharing one FIFO. With a single thread, handlers run in
+// arrival order.
+class ThreadPoolExecutor final : public Executor {
+public:
+    explicit ThreadPoolExecutor(std::size_t thread_count = 1, ErrorHandler on_error = {});
+    ~ThreadPoolExecutor() override;
+
+    ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+    ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+
+    void Post(Task task) override;
+
+    // Drops queued tasks and joins the threads; later posts are ignored.
+    void Stop();
+
+private:
+    void Run(std::stop_token stop_token);
+
+    std::mutex mutex_;
+    std::condition_variable_any cv_;
+    std::deque<Task> tasks_;
+    bool stopped_{false};
+    std::vector<std::jthread> threads_;
+};
+
+} // namespace minx::zmesh
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+
+#include <zmq.hpp>
+
+#include "payload.hpp"
+
+namespace minx::zmesh {
+
+// Outgoing multipart messages of one reactor channel, sent without blocking
+// the reactor thread. Messages are added frame by frame and go out in order;
+// when the socket would block, Send() stops and the unsent frames, including
+// the rest of a partly sent message, stay at the front for the next call. A
+// message a ROUTER_MANDATORY router cannot route, its peer being gone, is
+// dropped.
+class FrameWriter {
+public:
+    // Copies the frame. more marks every frame but a message's last.
+    void Add(const zmq::const_buffer& frame, bool more);
+    // Large payloads that own their bytes are handed over without a copy.
+    void Add(const Payload& payload, bool more);
+
+    // True once every frame is sent; false if the socket would block.
+    bool Send(zmq::socket_t& socket);
+
+    [[nodiscard]] bool empty() const noexcept {
+        return frames_.empty();
+    }
+
+    // Messages not yet fully sent, counting one whose last frame is added.
+    [[nodiscard]] std::size_t message_count() const noexcept {
+        return message_count_;
+    }
+
+private:
+    // Discards the front message, the one whose first frame failed to send.
+    void DropMessage() noexcept;
+
+    struct Frame {
+        zmq::message_t message;
+        bool more;
+    };
+
+    std::deque<Frame> frames_;
+    std::size_t message_count_{0};
+};
+
+} // namespace minx::zmesh
@@ -1,34 +1,109 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <functional>
 #include <future>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <utility>
 
+#include "ask_awaitable.hpp"
+#include "bounded_queue.hpp"
+#include "content_type.hpp"
+#include "payload.hpp"
 #include "pending_question.hpp"
 #include "types.hpp"
 
 namespace minx::zmesh {
 
+struct HandlerOptions {
+    // By default a content type's handler calls run one at a time, in arrival
+    // order. Unordered handlers may run concurrently on every executor thread;
+    // use it for stateless content types.
+    bool unordered = false;
+};
+
 class IAbstractMessageBox {
 public:
     using TellHandler = std::function<void(const std::string&)>;
     using QuestionHandler = std::function<Answer(const std::string&)>;
+    // View handlers see the received frame in place; the view is only valid
+    // for the duration of the call.
+    using TellViewHandler = std::function<void(std::string_view)>;
+    using QuestionViewHandler = std::function<Answer(std::string_view)>;
+    // Batch handlers receive every drained item at once; answers[i] is the
+    // reply to questions[i] and starts out default constructed.
+    using TellBatchHandler = std::function<void(std::span<const std::string_view>)>;
+    using QuestionBatchHandler =
+        std::function<void(std::span<const std::string_view> questions, std::span<Answer> answers)>;
+    // Called for every chunk of every stream of a content type, one call at a
+    // time and in order within a stream.
+    using TellStreamHandler = std::function<void(const StreamChunk&)>;
 
     virtual ~IAbstractMessageBox() = default;
 
-    virtual void Tell(std::string content_type, std::string content) = 0;
-    virtual bool TryListen(const std::string& content_type, const TellHandler& handler) = 0;
+    virtual void Tell(ContentType content_type, std::string content) = 0;
+    // Payload overloads hand the buffer to ZeroMQ without copying it.
+    virtual void Tell(ContentType content_type, Payload content) = 0;
+    // Push-based delivery: once a handler is registered, messages of that
+    // content type (including any already queued) go to the handler on the
+    // mesh's executor instead of the Try* queues. An empty handler unregisters.
+    // Respond() is the push-based TryAnswer().
+    virtual void Listen(ContentType content_type, TellViewHandler handler, HandlerOptions options = {}) = 0;
+    virtual void Respond(ContentType question_content_type,
+                         QuestionViewHandler handler,
+                         HandlerOptions options = {}) = 0;
+
+    // Sends content in chunks of ZMeshOptions::streams.chunk_size, interleaved
+    // with the box's other messages; receivers see it through ListenStream().
+    // Text peers cannot stream and receive one ordinary Tell instead, so the
+    // whole stream is buffered in memory for them.
+    virtual void TellStream(ContentType content_type, Payload content) = 0;
+    // Pulls the chunks from source as the receiver's window allows, on the
+    // reactor thread of the box's dealer, so source must not block for long.
+    virtual void TellStream(ContentType content_type, StreamSource source) = 0;
+    // Push-based delivery of streamed Tells. Chunks arriving before a handler
+    // is registered wait for it; an empty handler unregisters.
+    virtual void ListenStream(ContentType content_type, TellStreamHandler handler) = 0;
+
+    virtual bool TryListen(ContentType content_type, const TellHandler& handler) = 0;
+    virtual bool TryListenView(ContentType content_type, const TellViewHandler& handler) = 0;
+    virtual std::size_t TryListenBatch(ContentType content_type,
+                                       std::size_t max_messages,
+                                       const TellBatchHandler& handler) = 0;
+
+    virtual std::future<Answer> Ask(ContentType content_type) = 0;
+    virtual std::future<Answer> Ask(ContentType content_type, std::string content) = 0;
+    virtual std::future<Answer> Ask(ContentType content_type, std::chrono::milliseconds timeout) = 0;
+    virtual std::future<Answer> Ask(ContentType content_type, std::string content, std::chrono::milliseconds timeout) = 0;
+    virtual std::future<Answer> Ask(ContentType content_type, Payload content) = 0;
+    virtual std::future<Answer> Ask(ContentType content_type, Payload content, std::chrono::milliseconds timeout) = 0;
+
+    // co_await-able Ask; see AskAwaitable.
+    virtual AskAwaitable AskAsync(ContentType content_type, Payload content, AskOptions options = {}) = 0;
+    AskAwaitable AskAsync(ContentType content_type, std::string content = {}, AskOptions options = {}) {
+        return AskAsync(content_type, Payload(std::move(content)), options);
+    }
 
-    virtual std::future<Answer> Ask(const std::string& content_type) = 0;
-    virtual std::future<Answer> Ask(const std::string& content_type, std::string content) = 0;
-    virtual std::future<Answer> Ask(const std::string& content_type, std::chrono::milliseconds timeout) = 0;
-    virtual std::future<Answer> Ask(const std::string& content_type, std::string content, std::chrono::milliseconds timeout) = 0;
+    virtual bool TryAnswer(ContentType question_content_type, const QuestionHandler& handler) = 0;
+    virtual bool TryAnswerView(ContentType question_content_type, const QuestionViewHandler& handler) = 0;
+    virtual std::size_t TryAnswerBatch(ContentType question_content_type,
+                                       std::size_t max_questions,
+                                       const QuestionBatchHandler& handler) = 0;
 
-    virtual bool TryAnswer(const std::string& question_content_type, const QuestionHandler& handler) = 0;
+    virtual std::optional<PendingQuestion> GetQuestion(ContentType question_type) = 0;
 
-    virtual std::optional<PendingQuestion> GetQuestion(const std::string& question_type) = 0;
+    // Bounds the queues holding a content type's messages, questions and
+    // stream chunks while no handler is registered. The overload without a content type replaces
+    // the box default (ZMeshOptions::inbox_limit) for every content type.
+    virtual void SetInboxLimit(QueueLimit limit) = 0;
+    virtual void SetInboxLimit(ContentType content_type, QueueLimit limit) = 0;
+    // Tell and question counters of the content type, summed.
+    virtual QueueCounters GetInboxCounters(ContentType content_type) = 0;
+    virtual QueueCounters GetOutgoingCounters() = 0;
 };
 
 } // namespace minx::zmesh
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_set>
+
+#include "bounded_queue.hpp"
+#include "content_type.hpp"
+#include "content_type_map.hpp"
+#include "executor.hpp"
+#include "iabstract_message_box.hpp"
+#include "metrics.hpp"
+#include "pending_chunk.hpp"
+#include "pending_question.hpp"
+#include "serial_lane.hpp"
+
+namespace minx::zmesh {
+
+// Receiving side of a message box hosted by this mesh: the queued messages
+// and questions per content type and the handlers registered for them. It owns
+// no socket or thread, so hosting a box costs only this object and its queues.
+// Sending to a box goes through AbstractMessageBox, the remote proxy.
+class MessageInbox : public std::enable_shared_from_this<MessageInbox> {
+public:
+    using TellHandler = IAbstractMessageBox::TellHandler;
+    using QuestionHandler = IAbstractMessageBox::QuestionHandler;
+    using TellViewHandler = IAbstractMessageBox::TellViewHandler;
+    using QuestionViewHandler = IAbstractMessageBox::QuestionViewHandler;
+    using TellBatchHandler = IAbstractMessageBox::TellBatchHandler;
+    using QuestionBatchHandler = IAbstractMessageBox::QuestionBatchHandler;
+    using TellStreamHandler = IAbstractMessageBox::TellStreamHandler;
+
+    MessageInbox(std::string name, Executor& executor, QueueLimit inbox_limit = {});
+
+    MessageInbox(const MessageInbox&) = delete;
+    MessageInbox& operator=(const MessageInbox&) = delete;
+
+    void Listen(ContentType content_type, TellViewHandler handler, HandlerOptions options = {});
+    void Respond(ContentType question_content_type, QuestionViewHandler handler, HandlerOptions options = {});
+    void ListenStream(ContentType content_type, TellStreamHandler handler);
+
+    bool TryListen(ContentType content_type, const TellHandler& handler);
+    bool TryListenView(ContentType content_type, const TellViewHandler& handler);
+    std::size_t TryListenBatch(ContentType content_type, std::size_t max_messages, const TellBatchHandler& handler);
+
+    bool TryAnswer(ContentType question_content_type, const QuestionHandler& handler);
+    bool TryAnswerView(ContentType question_content_type, const QuestionViewHandler& handler);
+    std::size_t TryAnswerBatch(ContentType question_content_type,
+                               std::size_t max_questions,
+                               const QuestionBatchHandler& handler);
+    std::optional<PendingQuestion> GetQuestion(ContentType question_type);
+
+    void SetInboxLimit(QueueLimit limit);
+    void SetInboxLimit(ContentType content_type, QueueLimit limit);
+    QueueCounters GetInboxCounters(ContentType content_type);
+    InboxMetrics GetMetrics();
+
+    void ReceiveTell(ContentType content_type, Payload content);
+    void ReceiveQuestion(PendingQuestion pending_question);
+    void ReceiveChunk(PendingChunk pending_chunk);
+
+private:
+    // A registered handler and, unless it is unordered, the lane that keeps
+    // its calls serial.
+    template <typename Handler>
+    struct Registration {
+        Handler handler;
+        std::shared_ptr<SerialLane> lane;
+    };
+
+    using TellRegistration = Registration<TellViewHandler>;
+    using QuestionRegistration = Registration<QuestionViewHandler>;
+    using StreamRegistration = Registration<TellStreamHandler>;
+
+    // Everything received for one content type. Once a handler is registered
+    // messages go straight to it; until then they wait in the queue. The mutex
+    // only serialises handing the queue over to a handler, so registration
+    // never strands a message; pushes to the queues never take it.
+    // Waiting stream chunks share the limit: a stream's window bounds its own
+    // chunks, but not how many streams are opened before a handler is.
+    struct Inbox {
+        Inbox(ContentType inbox_content_type, QueueLimit limit)
+            : content_type(inbox_content_type),
+              messages(limit),
+              pending_questions(limit),
+              pending_chunks(limit) {}
+
+        const ContentType content_type;
+        std::mutex mutex;
+        std::atomic<std::shared_ptr<const TellRegistration>> tell_handler;
+        std::atomic<std::shared_ptr<const QuestionRegistration>> question_handler;
+        std::atomic<std::shared_ptr<const StreamRegistration>> stream_handler;
+        BoundedQueue<Payload> messages;
+        BoundedQueue<PendingQuestion> pending_questions;
+        BoundedQueue<PendingChunk> pending_chunks;
+
+        // Streams that lost a chunk to the limit. Their later chunks are
+        // discarded and their last one is delivered empty and aborted.
+        std::mutex reset_streams_mutex;
+        std::unordered_set<CorrelationId> reset_streams;
+        std::atomic<std::size_t> reset_stream_count{0};
+
+        std::atomic<std::uint64_t> tells_received{0};
+        std::atomic<std::uint64_t> questions_received{0};
+        std::atomic<std::uint64_t> chunks_received{0};
+    };
+
+    Inbox& GetInbox(ContentType content_type);
+
+    bool DiscardResetChunk(Inbox& inbox, PendingChunk& pending_chunk);
+    void ResetStream(Inbox& inbox, const PendingChunk& dropped);
+
+    void PostHandler(const std::shared_ptr<SerialLane>& lane, Executor::Task task);
+    void PostTell(std::shared_ptr<const TellRegistration> registration, Payload content);
+    void PostQuestion(std::shared_ptr<const QuestionRegistration> registration, PendingQuestion pending_question);
+    void PostChunk(std::shared_ptr<const StreamRegistration> registration, PendingChunk pending_chunk);
+
+    void SendAnswer(const PendingQuestion& pending_question, const Answer& answer);
+    void SendRejection(const PendingQuestion& pending_question, std::string reason);
+    void Reply(const PendingQuestion& pending_question, AnswerMessage answer_message);
+    void SendCredit(const PendingChunk& pending_chunk);
+
+    std::string name_;
+    Executor& executor_;
+
+    // Held while creating an inbox, so none is created with a stale default.
+    std::mutex inbox_limit_mutex_;
+    QueueLimit inbox_limit_;
+    ContentTypeMap<Inbox> inboxes_;
+};
+
+} // namespace minx::zmesh
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bounded_queue.hpp"
+
+namespace minx::zmesh {
+
+// Point-in-time copy of a LatencyHistogram. Only occupied buckets are kept, as
+// (highest value in the bucket, count) pairs in ascending order.
+struct HistogramSnapshot {
+    std::uint64_t count = 0;
+    std::chrono::nanoseconds sum{0};
+    std::chrono::nanoseconds max{0};
+    std::vector<std::pair<std::chrono::nanoseconds, std::uint64_t>> buckets;
+
+    // Upper bound of the bucket holding the given percentile (0-100).
+    [[nodiscard]] std::chrono::nanoseconds Percentile(double percentile) const;
+    [[nodiscard]] std::chrono::nanoseconds Mean() const;
+};
+
+// Log-linear histogram in the style of HdrHistogram: each power of two is
+// split into 16 linear buckets, so a value is reported at most 1/16 above what
+// was recorded. Record() is a few relaxed atomic operations and Snapshot()
+// reads without stopping writers; a snapshot may miss records in flight.
+class LatencyHistogram {
+public:
+    LatencyHistogram() = default;
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void Record(std::chrono::nanoseconds value) noexcept;
+    [[nodiscard]] HistogramSnapshot Snapshot() const;
+
+private:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr std::size_t kSubBuckets = std::size_t{1} << kSubBucketBits;
+    static constexpr std::size_t kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    static std::size_t BucketIndex(std::uint64_t value) noexcept;
+    static std::uint64_t BucketUpperBound(std::size_t index) noexcept;
+
+    std::array<std::atomic<std::uint64_t>, kBuckets> counts_{};
+    std::atomic<std::uint64_t> sum_{0};
+    std::atomic<std::uint64_t> max_{0};
+};
+
+// Receiving side of one content type of a box hosted by the mesh.
+struct ContentTypeMetrics {
+    std::string content_type;
+    std::uint64_t tells_received = 0;
+    std::uint64_t questions_received = 0;
+    std::uint64_t chunks_received = 0;
+    // Waiting for TryListen()/TryAnswer() or a handler to be registered.
+    std::size_t queued_messages = 0;
+    std::size_t queued_questions = 0;
+    QueueCounters inbox;
+};
+
+struct InboxMetrics {
+    std::string message_box;
+    std::vector<ContentTypeMetrics> content_types;
+};
+
+// Sending side of a box returned by ZMesh::At().
+struct MessageBoxMetrics {
+    std::string message_box;
+    std::uint64_t tells_sent = 0;
+    std::uint64_t questions_sent = 0;
+    // TellStream() calls, and the chunks they went out in; a stream sent to a
+    // text peer is one chunk.
+    std::uint64_t streams_sent = 0;
+    std::uint64_t chunks_sent = 0;
+    std::uint64_t answers_received = 0;
+    std::uint64_t asks_timed_out = 0;
+    // Rejected, dropped from the outgoing queue or failed by disposal.
+    std::uint64_t asks_failed = 0;
+    std::size_t pending_answers = 0;
+    std::size_t outgoing_depth = 0;
+    QueueCounters outgoing;
+    HistogramSnapshot ask_rtt;
+    // Time from Tell()/Ask() to the message being handed to ZeroMQ.
+    HistogramSnapshot enqueue_to_send;
+};
+
+struct MeshMetrics {
+    // Messages read from the router, whether or not a box took them.
+    std::uint64_t messages_received = 0;
+    std::uint64_t answers_sent = 0;
+    // Native dealers the router remembers greeting; see peer_idle_timeout.
+    std::size_t binary_peers = 0;
+    // Tells dropped and Asks refused because their content type was new and
+    // the mesh had interned its limit of names from peers.
+    std::uint64_t content_types_refused = 0;
+    std::vector<MessageBoxMetrics> message_boxes;
+    std::vector<InboxMetrics> inboxes;
+};
+
+} // namespace minx::zmesh
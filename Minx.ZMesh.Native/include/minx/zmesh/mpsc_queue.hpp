@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace minx::zmesh {
+
+// Multi-producer, single-consumer queue with the push/try_pop/close contract
+// of ThreadSafeQueue, minus wait_pop: its consumer is a reactor channel that
+// is scheduled rather than woken. Pushes go into a bounded lock-free ring (one
+// CAS, no allocation); when the ring is full they spill into a mutex-protected
+// overflow list until the consumer has drained it, so push never blocks and
+// only fails once the queue is closed. Items from one producer are always
+// popped in the order pushed.
+template <typename T>
+class MpscQueue {
+public:
+    explicit MpscQueue(std::size_t capacity = 64)
+        : mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1),
+          cells_(std::make_unique<Cell[]>(mask_ + 1)) {
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // False, with value dropped, once close() has been called.
+    bool push(T value) {
+        if (closed_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        if (!overflow_active_.load(std::memory_order_acquire) && TryPushRing(value)) {
+            return true;
+        }
+
+        std::lock_guard lock(overflow_mutex_);
+        overflow_.push_back(std::move(value));
+        overflow_active_.store(true, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only.
+    [[nodiscard]] bool try_pop(T& value) {
+        if (TryPopRing(value)) {
+            return true;
+        }
+        if (!overflow_active_.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        std::lock_guard lock(overflow_mutex_);
+        // A producer may have finished a ring push before spilling; its ring
+        // items must be popped first.
+        if (enqueue_pos_.load(std::memory_order_relaxed) != dequeue_pos_) {
+            return TryPopRing(value);
+        }
+        if (overflow_.empty()) {
+            overflow_active_.store(false, std::memory_order_release);
+            return false;
+        }
+
+        value = std::move(overflow_.front());
+        overflow_.pop_front();
+        if (overflow_.empty()) {
+            overflow_active_.store(false, std::memory_order_release);
+        }
+        return true;
+    }
+
+    // Later pushes are refused; items already queued can still be popped.
+    void close() {
+        closed_.store(true, std::memory_order_release);
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence{0};
+        T value{};
+    };
+
+    bool TryPushRing(T& value) {
+        auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& cell = cells_[pos & mask_];
+            const auto sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TryPopRing(T& value) {
+        auto& cell = cells_[dequeue_pos_ & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+            return false;
+        }
+        value = std::move(cell.value);
+        cell.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_pos_;
+        return true;
+    }
+
+    const std::size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+
+    alignas(64) std::atomic<std::size_t> enqueue_pos_{0};
+    alignas(64) std::size_t dequeue_pos_{0};
+    std::atomic<bool> overflow_active_{false};
+
+    std::mutex overflow_mutex_;
+    std::deque<T> overflow_;
+    std::atomic<bool> closed_{false};
+};
+
+} // namespace minx::zmesh
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <zmq.hpp>
+
+namespace minx::zmesh {
+
+// Immutable, reference-counted message bytes. Copies share the same buffer, so
+// a received frame can travel from the socket to a handler without its bytes
+// being copied.
+class Payload {
+public:
+    Payload() = default;
+
+    explicit Payload(std::string value) {
+        auto owner = std::make_shared<const std::string>(std::move(value));
+        view_ = *owner;
+        owner_ = std::move(owner);
+    }
+
+    // Views bytes kept alive by owner, e.g. a caller's shared or pinned buffer.
+    Payload(std::shared_ptr<const void> owner, std::string_view view) noexcept
+        : owner_(std::move(owner)),
+          view_(view) {}
+
+    static Payload FromFrame(zmq::message_t&& frame) {
+        auto owner = std::make_shared<const zmq::message_t>(std::move(frame));
+        const std::string_view view(static_cast<const char*>(owner->data()), owner->size());
+        return Payload(std::move(owner), view);
+    }
+
+    [[nodiscard]] std::string_view view() const noexcept { return view_; }
+    [[nodiscard]] const char* data() const noexcept { return view_.data(); }
+    [[nodiscard]] std::size_t size() const noexcept { return view_.size(); }
+    [[nodiscard]] bool empty() const noexcept { return view_.empty(); }
+
+    [[nodiscard]] const std::shared_ptr<const void>& owner() const noexcept { return owner_; }
+
+    [[nodiscard]] std::string to_string() const { return std::string(view_); }
+
+private:
+    std::shared_ptr<const void> owner_;
+    std::string_view view_;
+};
+
+} // namespace minx::zmesh
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "answer_queue.hpp"
+#include "content_type.hpp"
+#include "payload.hpp"
+#include "types.hpp"
+
+namespace minx::zmesh {
+
+struct PendingChunk {
+    std::string dealer_identity;
+    CorrelationId stream_id{0};
+    ContentType content_type;
+    Payload content;
+    bool last{false};
+    bool aborted{false};
+    // Where the credit for the chunk goes once it is handled; null for
+    // streams from this mesh, which have no window.
+    std::shared_ptr<AnswerQueue> answer_queue;
+};
+
+} // namespace minx::zmesh
@@ -1,19 +1,31 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 
-#include "thread_safe_queue.hpp"
+#include "answer_queue.hpp"
+#include "tracing.hpp"
 #include "types.hpp"
 
 namespace minx::zmesh {
 
-using AnswerQueue = ThreadSafeQueue<IdentityMessage<AnswerMessage>>;
-
 struct PendingQuestion {
     std::string dealer_identity;
     QuestionMessage question_message;
     std::shared_ptr<AnswerQueue> answer_queue;
+    // Set for questions asked from this mesh: the answer goes straight back to
+    // the asking box instead of through answer_queue and the router.
+    std::function<void(AnswerMessage)> local_reply{};
+    // Set when question_message is traced; shared, since the question can
+    // outlive the mesh that received it.
+    std::shared_ptr<FlightRecorder> recorder{};
+
+    void Trace(TraceStage stage) const noexcept {
+        if (recorder) {
+            recorder->Record(question_message.trace_id, stage);
+        }
+    }
 };
 
 } // namespace minx::zmesh
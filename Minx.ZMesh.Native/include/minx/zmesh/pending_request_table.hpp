@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "types.hpp"
+
+namespace minx::zmesh {
+
+// Table of in-flight requests keyed by the correlation id it hands out. An id
+// encodes where the entry lives, so lookups never hash:
+//
+//   [generation:32][shard:4][slot:28]
+//
+// Each thread inserts into its own shard, so concurrent askers rarely share a
+// lock, and ids need no random generator. The generation changes every time a
+// slot is reused, so a late or duplicated answer for a finished request never
+// matches the slot's next occupant.
+template <typename T>
+class PendingRequestTable {
+public:
+    PendingRequestTable() = default;
+
+    PendingRequestTable(const PendingRequestTable&) = delete;
+    PendingRequestTable& operator=(const PendingRequestTable&) = delete;
+
+    CorrelationId Insert(T value) {
+        const auto shard_index = CurrentShard();
+        auto& shard = shards_[shard_index];
+
+        std::lock_guard lock(shard.mutex);
+        std::uint32_t slot_index;
+        if (!shard.free_slots.empty()) {
+            slot_index = shard.free_slots.back();
+            shard.free_slots.pop_back();
+        } else {
+            slot_index = static_cast<std::uint32_t>(shard.slots.size());
+            shard.slots.emplace_back();
+        }
+
+        auto& slot = shard.slots[slot_index];
+        slot.value = std::move(value);
+        slot.occupied = true;
+        shard.size.fetch_add(1, std::memory_order_relaxed);
+        return MakeId(slot.generation, shard_index, slot_index);
+    }
+
+    // Runs fn on the entry while it is still pending; false if it is gone.
+    template <typename Fn>
+    bool Update(CorrelationId id, Fn&& fn) {
+        auto& shard = ShardFor(id);
+        std::lock_guard lock(shard.mutex);
+        auto* slot = SlotFor(shard, id);
+        if (slot == nullptr) {
+            return false;
+        }
+        fn(slot->value);
+        return true;
+    }
+
+    std::optional<T> Take(CorrelationId id) {
+        auto& shard = ShardFor(id);
+        std::lock_guard lock(shard.mutex);
+        if (SlotFor(shard, id) == nullptr) {
+            return std::nullopt;
+        }
+        return Release(shard, id);
+    }
+
+    // Removes every pending entry, e.g. to fail them on shutdown.
+    std::vector<T> TakeAll() {
+        std::vector<T> values;
+        for (std::size_t shard_index = 0; shard_index < kShards; ++shard_index) {
+            auto& shard = shards_[shard_index];
+            std::lock_guard lock(shard.mutex);
+            for (std::uint32_t slot_index = 0; slot_index < shard.slots.size(); ++slot_index) {
+                const auto& slot = shard.slots[slot_index];
+                if (slot.occupied) {
+                    values.push_back(Release(shard, MakeId(slot.generation, shard_index, slot_index)));
+                }
+            }
+        }
+        return values;
+    }
+
+    // Number of pending entries, read without locking; approximate while
+    // entries come and go.
+    [[nodiscard]] std::size_t size() const noexcept {
+        std::size_t total = 0;
+        for (const auto& shard : shards_) {
+            total += shard.size.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    static constexpr int kSlotBits = 28;
+    static constexpr int kShardBits = 4;
+    static constexpr std::size_t kShards = std::size_t{1} << kShardBits;
+    static constexpr std::uint32_t kSlotMask = (std::uint32_t{1} << kSlotBits) - 1;
+
+    struct Slot {
+        T value{};
+        std::uint32_t generation{1};
+        bool occupied{false};
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::vector<Slot> slots;
+        std::vector<std::uint32_t> free_slots;
+        std::atomic<std::size_t> size{0};
+    };
+
+    static CorrelationId MakeId(std::uint32_t generation, std::size_t shard_index, std::uint32_t slot_index) {
+        return (static_cast<CorrelationId>(generation) << 32) |
+               (static_cast<CorrelationId>(shard_index) << kSlotBits) | slot_index;
+    }
+
+    static std::size_t CurrentShard() {
+        static std::atomic<std::size_t> next_shard{0};
+        thread_local const std::size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+        return shard;
+    }
+
+    Shard& ShardFor(CorrelationId id) {
+        return shards_[static_cast<std::size_t>((id >> kSlotBits) & (kShards - 1))];
+    }
+
+    static Slot* SlotFor(Shard& shard, CorrelationId id) {
+        const auto slot_index = static_cast<std::uint32_t>(id) & kSlotMask;
+        const auto generation = static_cast<std::uint32_t>(id >> 32);
+        if (slot_index >= shard.slots.size()) {
+            return nullptr;
+        }
+        auto& slot = shard.slots[slot_index];
+        if (!slot.occupied || slot.generation != generation) {
+            return nullptr;
+        }
+        return &slot;
+    }
+
+    static T Release(Shard& shard, CorrelationId id) {
+        const auto slot_index = static_cast<std::uint32_t>(id) & kSlotMask;
+        auto& slot = shard.slots[slot_index];
+        T value = std::move(slot.value);
+        slot.value = T{};
+        slot.occupied = false;
+        if (++slot.generation == 0) {
+            slot.generation = 1;
+        }
+        shard.free_slots.push_back(slot_index);
+        shard.size.fetch_sub(1, std::memory_order_relaxed);
+        return value;
+    }
+
+    std::array<Shard, kShards> shards_;
+};
+
+} // namespace minx::zmesh
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <zmq.hpp>
+
+#include "error_handler.hpp"
+#include "wakeup_signal.hpp"
+
+namespace minx::zmesh {
+
+// Shared I/O reactor for the sockets of one ZMesh. Each registered channel
+// is pinned to one of a small pool of threads which polls all of its
+// channels together and runs their handlers; sockets are only ever touched
+// from that thread once registered.
+//
+// on_readable runs when the channel's socket has an inbound message.
+// on_flush runs after Schedule() and is where channels drain their
+// outgoing queues. A handler that throws takes only its own channel down: the
+// socket is closed, the exception goes to the reactor's ErrorHandler and then
+// to the channel's on_error, and the thread carries on with the others.
+class Reactor {
+public:
+    using ChannelId = std::uint64_t;
+    using Handler = std::function<void(zmq::socket_t&)>;
+
+    Reactor(zmq::context_t& context, std::size_t thread_count, ErrorHandler on_error = {});
+    ~Reactor();
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    ChannelId Register(zmq::socket_t socket, Handler on_readable, Handler on_flush, ErrorHandler on_error = {});
+
+    // Blocks until the owning thread has closed the socket and will no longer
+    // invoke the channel's handlers. Safe to call from a handler, but not from
+    // a thread the owning thread may be waiting on, such as another reactor
+    // thread or a timer thread; use Detach() there.
+    void Unregister(ChannelId channel_id);
+
+    // Has the owning thread close the socket without waiting for it. Handlers
+    // may still run until then, so they must not rely on the caller being
+    // alive.
+    void Detach(ChannelId channel_id);
+
+    void Schedule(ChannelId channel_id);
+
+    // Runs the channel's on_flush once deadline has passed. Only callable from
+    // the channel's own handlers. A channel has at most one deadline pending;
+    // the earlier one is kept. The poll timeout is rounded up to whole
+    // milliseconds, so a deadline may be met up to a millisecond late.
+    void ScheduleAt(ChannelId channel_id, std::chrono::steady_clock::time_point deadline);
+
+    // Runs the channel's on_flush once its socket can take another message.
+    // Only callable from the channel's own handlers, after a send that would
+    // have blocked.
+    void WaitWritable(ChannelId channel_id);
+
+    void Stop();
+
+private:
+    struct Channel {
+        zmq::socket_t socket;
+        Handler on_readable;
+        Handler on_flush;
+        ErrorHandler on_error;
+        bool removed{false};
+        bool wants_writable{false};
+    };
+
+    struct Worker {
+        explicit Worker(zmq::context_t& context)
+            : signal(context) {}
+
+        WakeupSignal signal;
+
+        std::mutex mutex;
+        std::condition_variable changes_applied;
+        std::vector<std::pair<ChannelId, std::unique_ptr<Channel>>> added;
+        std::vector<ChannelId> removed;
+        std::vector<ChannelId> scheduled;
+        std::uint64_t requested_changes{0};
+        std::uint64_t applied_changes{0};
+        bool stopped{false};
+
+        // Owned by the worker thread.
+        std::unordered_map<ChannelId, std::unique_ptr<Channel>> channels;
+        std::vector<std::pair<std::chrono::steady_clock::time_point, ChannelId>> deferred;
+
+        std::jthread thread;
+    };
+
+    Worker& WorkerFor(ChannelId channel_id);
+    void Run(Worker& worker, std::stop_token stop_token);
+
+    const ErrorHandler on_error_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<ChannelId> next_channel_id_{0};
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> stopped_{false};
+};
+
+} // namespace minx::zmesh
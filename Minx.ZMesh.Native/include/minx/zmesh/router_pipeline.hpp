@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <zmq.hpp>
+
+#include "error_handler.hpp"
+#include "spsc_queue.hpp"
+
+namespace minx::zmesh {
+
+// Multipart message as read from the router: identity first, then up to five
+// message frames.
+struct RouterFrames {
+    std::array<zmq::message_t, 6> frames;
+    std::size_t count{0};
+    // When a traced question was read; set for those only.
+    std::chrono::steady_clock::time_point received_at{};
+};
+
+// Decode/dispatch stage behind the router. The receiving reactor thread
+// submits raw frames and N workers decode and dispatch them, each fed through
+// its own SPSC ring. Messages for the same box always go to the same worker,
+// so per-box arrival order is kept. A handler that throws is reported to
+// on_error and the worker carries on with the next message.
+class RouterPipeline {
+public:
+    using Handler = std::function<void(RouterFrames&)>;
+
+    RouterPipeline(std::size_t worker_count,
+                   std::size_t ring_capacity,
+                   Handler handler,
+                   ErrorHandler on_error = {});
+    ~RouterPipeline();
+
+    RouterPipeline(const RouterPipeline&) = delete;
+    RouterPipeline& operator=(const RouterPipeline&) = delete;
+
+    // Receiving thread only. Waits for room when the worker's ring is full,
+    // which pushes back on senders through the router's high-water mark.
+    void Submit(RouterFrames& message);
+
+    // Joins the workers; messages still queued are dropped.
+    void Stop();
+
+private:
+    struct Worker {
+        explicit Worker(std::size_t ring_capacity)
+            : ring(ring_capacity) {}
+
+        SpscQueue<RouterFrames> ring;
+        std::atomic<bool> sleeping{false};
+        std::atomic<std::uint32_t> wakeups{0};
+        std::jthread thread;
+    };
+
+    void Run(Worker& worker, std::stop_token stop_token);
+    static void Wake(Worker& worker);
+
+    Handler handler_;
+    const ErrorHandler on_error_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> stopped_{false};
+};
+
+} // namespace minx::zmesh
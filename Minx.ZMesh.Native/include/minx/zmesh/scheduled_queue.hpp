@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "bounded_queue.hpp"
+#include "mpsc_queue.hpp"
+#include "thread_safe_queue.hpp"
+#include "zmesh_options.hpp"
+
+namespace minx::zmesh {
+
+// Queue drained by a reactor channel. The first push after the consumer has
+// called rearm() invokes the schedule callback, so a burst of pushes costs
+// a single reactor wakeup.
+template <typename T>
+class ScheduledQueue {
+public:
+    // A limit with a capacity selects a BoundedQueue regardless of kind.
+    explicit ScheduledQueue(std::function<void()> schedule, QueueKind kind = QueueKind::Locked, QueueLimit limit = {})
+        : schedule_(std::move(schedule)) {
+        if (limit.capacity != 0) {
+            queue_.template emplace<BoundedQueue<T>>(limit);
+        } else if (kind == QueueKind::LockFree) {
+            queue_.template emplace<MpscQueue<T>>();
+        }
+    }
+
+    // Pushes after close() are dropped; the consumer may already be gone. As
+    // with BoundedQueue::push, value keeps whatever was not queued.
+    PushResult push(T& value) {
+        if (closed_.load(std::memory_order_acquire)) {
+            return PushResult::Closed;
+        }
+        const auto result = std::visit(
+            [&value](auto& queue) {
+                using Queue = std::decay_t<decltype(queue)>;
+                if constexpr (std::is_same_v<Queue, BoundedQueue<T>>) {
+                    return queue.push(value);
+                } else if constexpr (std::is_same_v<Queue, MpscQueue<T>>) {
+                    // Closed in the meantime.
+                    return queue.push(std::move(value)) ? PushResult::Pushed : PushResult::Closed;
+                } else {
+                    queue.push(std::move(value));
+                    return PushResult::Pushed;
+                }
+            },
+            queue_);
+        if (result != PushResult::Pushed && result != PushResult::DroppedOldest) {
+            return result;
+        }
+        // Pairs with the fence in rearm(): either this push sees the consumer
+        // rearmed, or the consumer's drain sees this item.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!scheduled_.exchange(true, std::memory_order_acq_rel)) {
+            schedule_();
+        }
+        return result;
+    }
+
+    PushResult push(T&& value) {
+        return push(value);
+    }
+
+    // Called by the consumer before it drains the queue.
+    void rearm() noexcept {
+        scheduled_.store(false, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    [[nodiscard]] bool try_pop(T& value) {
+        return std::visit([&value](auto& queue) { return queue.try_pop(value); }, queue_);
+    }
+
+    // Only bounded queues apply a policy and keep counters.
+    [[nodiscard]] QueueCounters counters() const {
+        if (const auto* queue = std::get_if<BoundedQueue<T>>(&queue_)) {
+            return queue->counters();
+        }
+        return {};
+    }
+
+    void close() {
+        closed_.store(true, std::memory_order_release);
+        std::visit([](auto& queue) { queue.close(); }, queue_);
+    }
+
+private:
+    std::function<void()> schedule_;
+    std::variant<ThreadSafeQueue<T>, MpscQueue<T>, BoundedQueue<T>> queue_;
+    std::atomic<bool> scheduled_{false};
+    std::atomic<bool> closed_{false};
+};
+
+} // namespace minx::zmesh
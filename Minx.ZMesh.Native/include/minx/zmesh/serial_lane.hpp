@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "executor.hpp"
+#include "mpsc_queue.hpp"
+
+namespace minx::zmesh {
+
+// Serializes tasks on top of any executor: tasks posted to one lane run one
+// at a time, in posting order, but different lanes run in parallel. An idle
+// lane costs nothing; a busy one occupies a single executor task that yields
+// after a batch so other lanes are not starved.
+class SerialLane : public std::enable_shared_from_this<SerialLane> {
+public:
+    explicit SerialLane(Executor& executor);
+
+    SerialLane(const SerialLane&) = delete;
+    SerialLane& operator=(const SerialLane&) = delete;
+
+    void Post(Executor::Task task);
+
+private:
+    void Drain();
+
+    Executor& executor_;
+    MpscQueue<Executor::Task> tasks_;
+    std::atomic<std::size_t> pending_{0};
+};
+
+} // namespace minx::zmesh
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+
+namespace minx::zmesh {
+
+// Bounded single-producer, single-consumer ring. Each side owns one index and
+// caches the other's, so a push or pop touches shared cache lines only when
+// the cached view says the ring looks full or empty.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(std::size_t capacity = 1024)
+        : mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1),
+          cells_(std::make_unique<T[]>(mask_ + 1)) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer only. Leaves value untouched and returns false when full.
+    [[nodiscard]] bool try_push(T& value) {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) {
+                return false;
+            }
+        }
+        cells_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only.
+    [[nodiscard]] bool try_pop(T& value) {
+        const auto head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+        }
+        value = std::move(cells_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    const std::size_t mask_;
+    std::unique_ptr<T[]> cells_;
+
+    alignas(64) std::atomic<std::size_t> head_{0};
+    std::size_t cached_tail_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    std::size_t cached_head_{0};
+};
+
+} // namespace minx::zmesh
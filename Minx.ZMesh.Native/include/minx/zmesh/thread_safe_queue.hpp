@@ -1,10 +1,14 @@
 #pragma once
 
+#include <algorithm>
 #include <condition_variable>
 #include <deque>
+#include <iterator>
 #include <mutex>
 #include <optional>
 #include <chrono>
+#include <cstddef>
+#include <vector>
 
 namespace minx::zmesh {
 
@@ -31,6 +35,17 @@ public:
         return true;
     }
 
+    // Moves up to max_items from the front into out under a single lock.
+    std::size_t drain_into(std::vector<T>& out, std::size_t max_items) {
+        std::lock_guard lock(mutex_);
+        const auto count = std::min(max_items, queue_.size());
+        out.insert(out.end(),
+                   std::make_move_iterator(queue_.begin()),
+                   std::make_move_iterator(queue_.begin() + static_cast<std::ptrdiff_t>(count)));
+        queue_.erase(queue_.begin(), queue_.begin() + static_cast<std::ptrdiff_t>(count));
+        return count;
+    }
+
     template <typename Rep, typename Period>
     [[nodiscard]] bool wait_pop(T& value, const std::chrono::duration<Rep, Period>& timeout) {
         std::unique_lock lock(mutex_);
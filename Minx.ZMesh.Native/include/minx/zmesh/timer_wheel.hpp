@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace minx::zmesh {
+
+// Hierarchical timer wheel serviced by a single thread. Schedule() and
+// Cancel() are O(1); callbacks run on the wheel thread, outside its lock.
+// The thread sleeps until the next occupied slot and does not wake at all
+// while no timers are pending.
+class TimerWheel {
+public:
+    using TimerId = std::uint64_t;
+    using Callback = std::function<void()>;
+
+    static constexpr TimerId kInvalidTimer = 0;
+
+    explicit TimerWheel(std::chrono::milliseconds resolution = std::chrono::milliseconds{1});
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    TimerId Schedule(std::chrono::milliseconds delay, Callback callback);
+
+    // Returns false if the timer already fired, is firing, or was cancelled.
+    bool Cancel(TimerId timer_id);
+
+    void Stop();
+
+private:
+    static constexpr int kSlotBits = 6;
+    static constexpr std::size_t kSlots = std::size_t{1} << kSlotBits;
+    static constexpr std::uint64_t kSlotMask = kSlots - 1;
+    static constexpr int kLevels = 4;
+    static constexpr std::uint32_t kNil = 0xFFFFFFFFu;
+
+    struct Timer {
+        Callback callback;
+        std::uint64_t expiry{0};
+        std::uint32_t prev{kNil};
+        std::uint32_t next{kNil};
+        std::uint32_t generation{0};
+        std::uint8_t level{0};
+        std::uint8_t slot{0};
+        bool active{false};
+    };
+
+    struct Level {
+        std::array<std::uint32_t, kSlots> heads;
+        std::uint64_t occupied{0};
+    };
+
+    std::uint64_t NowTick() const;
+    void Insert(std::uint32_t index);
+    void Unlink(std::uint32_t index);
+    void Release(std::uint32_t index);
+    void Cascade(int level);
+    void Advance(std::uint64_t target_tick, std::vector<Callback>& expired);
+    std::uint64_t NextWakeTick() const;
+    void Run(std::stop_token stop_token);
+
+    const std::chrono::steady_clock::duration resolution_;
+    const std::chrono::steady_clock::time_point epoch_;
+
+    std::mutex mutex_;
+    std::condition_variable_any cv_;
+    std::vector<Timer> timers_;
+    std::vector<std::uint32_t> free_timers_;
+    std::array<Level, kLevels> levels_;
+    std::uint64_t current_tick_{0};
+    std::uint64_t next_wake_tick_{std::numeric_limits<std::uint64_t>::max()};
+    std::size_t active_count_{0};
+
+    std::jthread thread_;
+};
+
+} // namespace minx::zmesh
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "types.hpp"
+#include "zmesh_options.hpp"
+
+namespace minx::zmesh {
+
+// Points a sampled Ask passes on its way. The asking mesh records Enqueued,
+// Sent and Answered (or Failed); the answering mesh the stages in between.
+enum class TraceStage : std::uint8_t {
+    // Placed on the asking box's outgoing queue.
+    Enqueued,
+    // Written to the dealer by its reactor thread.
+    Sent,
+    // Read from the router.
+    RouterReceived,
+    // Decoded and handed to the box's inbox.
+    Dispatched,
+    // Queued in the inbox or posted to the Respond() handler.
+    InboxQueued,
+    HandlerStarted,
+    HandlerFinished,
+    // Pushed to the answer queue.
+    AnswerQueued,
+    // Written to the router.
+    AnswerSent,
+    Answered,
+    // Timed out, rejected or dropped.
+    Failed
+};
+
+inline constexpr std::string_view to_string(TraceStage stage) noexcept {
+    switch (stage) {
+    case TraceStage::Enqueued:
+        return "Enqueued";
+    case TraceStage::Sent:
+        return "Sent";
+    case TraceStage::RouterReceived:
+        return "RouterReceived";
+    case TraceStage::Dispatched:
+        return "Dispatched";
+    case TraceStage::InboxQueued:
+        return "InboxQueued";
+    case TraceStage::HandlerStarted:
+        return "HandlerStarted";
+    case TraceStage::HandlerFinished:
+        return "HandlerFinished";
+    case TraceStage::AnswerQueued:
+        return "AnswerQueued";
+    case TraceStage::AnswerSent:
+        return "AnswerSent";
+    case TraceStage::Answered:
+        return "Answered";
+    case TraceStage::Failed:
+        return "Failed";
+    }
+    return "";
+}
+
+struct TraceEvent {
+    TraceId trace_id{0};
+    TraceStage stage{TraceStage::Enqueued};
+    // Index of the recording thread's ring, in the order threads first recorded.
+    std::uint32_t thread{0};
+    std::chrono::steady_clock::time_point at;
+};
+
+enum class TraceFormat {
+    // Chrome trace event JSON (chrome://tracing, Perfetto): one instant event
+    // per stage, with the trace id as an argument.
+    ChromeTrace,
+    // "ZMTR", version:4 LE, event count:8 LE, then per event
+    // [trace id:8 LE][steady clock ns:8 LE][thread:4 LE][stage:1].
+    Binary
+};
+
+// Flight recorder for sampled Asks. Every thread that records gets its own
+// ring of ring_capacity events, written without locks or allocation; once full
+// it keeps the newest events. The steady clock is shared by the processes on a
+// host, so dumps of meshes talking to each other can be merged by trace id.
+class FlightRecorder {
+public:
+    explicit FlightRecorder(TracingOptions options);
+    ~FlightRecorder();
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    // A new trace id for every sample_every-th call, otherwise 0.
+    [[nodiscard]] TraceId Sample() noexcept;
+
+    // No-ops for trace id 0.
+    void Record(TraceId trace_id, TraceStage stage) noexcept;
+    void Record(TraceId trace_id, TraceStage stage, std::chrono::steady_clock::time_point at) noexcept;
+
+    // The events the rings still hold, oldest first per thread. Safe while
+    // threads record: events overwritten during the copy are left out.
+    [[nodiscard]] std::vector<TraceEvent> Events() const;
+    void Dump(std::ostream& out, TraceFormat format = TraceFormat::ChromeTrace) const;
+
+private:
+    struct Ring;
+
+    Ring& ThreadRing();
+
+    const std::uint32_t sample_every_;
+    const std::size_t ring_capacity_;
+    // Tells this recorder's rings apart in the threads' ring caches.
+    const std::uint64_t id_;
+    // Random, so trace ids from different processes don't collide.
+    const TraceId trace_id_base_;
+    std::atomic<std::uint64_t> samples_{0};
+
+    mutable std::mutex rings_mutex_;
+    std::vector<std::unique_ptr<Ring>> rings_;
+};
+
+} // namespace minx::zmesh
@@ -2,17 +2,27 @@
 
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <ostream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 
+#include "content_type.hpp"
+#include "payload.hpp"
+
 namespace minx::zmesh {
 
-enum class MessageType {
+using CorrelationId = std::uint64_t;
+// Identifies a sampled Ask across meshes; 0 means not traced.
+using TraceId = std::uint64_t;
+
+// The numeric values are the type byte of the binary wire header.
+enum class MessageType : std::uint8_t {
     Tell,
     Question,
-    Answer
+    Answer,
+    Hello
 };
 
 inline constexpr std::string_view to_string(MessageType type) noexcept {
@@ -23,6 +33,8 @@ inline constexpr std::string_view to_string(MessageType type) noexcept {
         return "Question";
     case MessageType::Answer:
         return "Answer";
+    case MessageType::Hello:
+        return "Hello";
     }
     return "";
 }
@@ -55,22 +67,53 @@ inline std::ostream& operator<<(std::ostream& os, const Answer& answer) {
 
 struct TellMessage {
     std::string message_box_name;
-    std::string content_type;
-    std::string content;
+    ContentType content_type;
+    Payload content;
 };
 
 struct QuestionMessage {
     std::string message_box_name;
-    std::string correlation_id;
-    std::string content_type;
-    std::string content;
+    CorrelationId correlation_id{0};
+    // Correlation id as received from a text peer, echoed back verbatim.
+    std::string text_correlation_id{};
+    ContentType content_type;
+    Payload content;
+    TraceId trace_id{0};
+};
+
+// Produces a streamed Tell's chunks one at a time; an empty Payload ends the
+// stream.
+using StreamSource = std::function<Payload()>;
+
+struct StreamMessage {
+    std::string message_box_name;
+    ContentType content_type;
+    StreamSource source;
+};
+
+// One chunk of a streamed Tell, as seen by a ListenStream() handler. The view
+// is only valid for the duration of the call.
+struct StreamChunk {
+    CorrelationId stream_id{0};
+    std::string_view content;
+    bool last{false};
+    // The sender's source threw or the inbox limit dropped one of the
+    // stream's chunks: this last chunk is empty and the stream is incomplete.
+    bool aborted{false};
 };
 
 struct AnswerMessage {
     std::string message_box_name;
-    std::string correlation_id;
+    CorrelationId correlation_id{0};
+    std::string text_correlation_id{};
     std::string content_type;
     std::string content;
+    // The question was refused; content holds the reason.
+    bool rejected{false};
+    // Not an answer: gives one chunk of window back to the stream whose id is
+    // correlation_id.
+    bool stream_credit{false};
+    TraceId trace_id{0};
 };
 
 template <typename T>
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include <zmq.hpp>
+
+namespace minx::zmesh {
+
+// Pollable cross-thread wakeup built on an inproc PAIR socket pair.
+// Notify() may be called from any thread; the owning loop polls PollItem()
+// next to its other sockets and calls Consume() once it has been woken.
+// Notifications are coalesced, so a burst of Notify() calls costs at most
+// one inproc message until the loop consumes it.
+class WakeupSignal {
+public:
+    explicit WakeupSignal(zmq::context_t& context);
+
+    WakeupSignal(const WakeupSignal&) = delete;
+    WakeupSignal& operator=(const WakeupSignal&) = delete;
+
+    void Notify();
+    void Consume();
+
+    [[nodiscard]] zmq::pollitem_t PollItem();
+
+private:
+    zmq::socket_t receiver_;
+    zmq::socket_t sender_;
+    std::mutex sender_mutex_;
+    std::atomic<bool> pending_{false};
+};
+
+} // namespace minx::zmesh
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "types.hpp"
+
+namespace minx::zmesh {
+
+// Native peers exchange a fixed 12 byte header frame instead of the text type
+// and correlation frames used by the C# Minx.ZMesh peers:
+//
+//   [version:1][type:1][flags:2 LE][correlation id:8 LE]
+//
+// Binary sequences are [header][message box][content type][content]. A text
+// type frame never starts with the version byte, so receivers tell the two
+// formats apart from the first frame alone.
+enum class WireFormat : std::uint8_t {
+    Text,
+    Binary
+};
+
+inline constexpr std::uint8_t kWireVersion = 1;
+inline constexpr std::size_t kWireHeaderSize = 12;
+
+// Dealers that understand the binary header prefix their routing id with this
+// marker. A native router greets such dealers with a Hello header, after which
+// they switch to binary. C# peers never see the marker or the Hello.
+inline constexpr std::string_view kBinaryPeerIdentityPrefix = "zm1-";
+
+// Header flags. A rejected Answer carries the reason as its content instead of
+// an answer; text peers never receive one.
+inline constexpr std::uint16_t kWireFlagRejected = 0x0001;
+// A batched Tell is [header][message box][records] and packs several Tells for
+// one box into the records frame, each encoded as
+//
+//   [content type length:2 LE][content type][content length:4 LE][content]
+inline constexpr std::uint16_t kWireFlagBatch = 0x0002;
+
+inline constexpr std::size_t kBatchRecordOverhead = 6;
+// The content frame of a Tell, Question or Answer is compressed; see Compressor.
+inline constexpr std::uint16_t kWireFlagLz4 = 0x0004;
+inline constexpr std::uint16_t kWireFlagZstd = 0x0008;
+inline constexpr std::uint16_t kWireCompressionFlags = kWireFlagLz4 | kWireFlagZstd;
+// A chunk of a streamed Tell; the correlation id is the stream id and the last
+// chunk also carries kWireFlagLastChunk. An empty last chunk that also carries
+// kWireFlagRejected ends a stream whose source failed. An Answer with
+// kWireFlagChunk and empty content frames returns one chunk of window to the
+// stream's sender.
+inline constexpr std::uint16_t kWireFlagChunk = 0x0010;
+inline constexpr std::uint16_t kWireFlagLastChunk = 0x0020;
+// A sampled Question is followed by a trace frame, [trace id:8 LE], so the
+// answering mesh can record its stages under the asker's trace id.
+inline constexpr std::uint16_t kWireFlagTraced = 0x0040;
+
+inline constexpr std::size_t kTraceFrameSize = 8;
+
+using WireHeaderBytes = std::array<std::uint8_t, kWireHeaderSize>;
+
+struct WireHeader {
+    MessageType type{MessageType::Tell};
+    std::uint16_t flags{0};
+    CorrelationId correlation_id{0};
+};
+
+inline WireHeaderBytes EncodeWireHeader(const WireHeader& header) noexcept {
+    WireHeaderBytes bytes{};
+    bytes[0] = kWireVersion;
+    bytes[1] = static_cast<std::uint8_t>(header.type);
+    bytes[2] = static_cast<std::uint8_t>(header.flags);
+    bytes[3] = static_cast<std::uint8_t>(header.flags >> 8);
+    for (std::size_t i = 0; i < 8; ++i) {
+        bytes[4 + i] = static_cast<std::uint8_t>(header.correlation_id >> (8 * i));
+    }
+    return bytes;
+}
+
+inline std::optional<WireHeader> DecodeWireHeader(const void* data, std::size_t size) noexcept {
+    if (size != kWireHeaderSize) {
+        return std::nullopt;
+    }
+
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    if (bytes[0] != kWireVersion || bytes[1] > static_cast<std::uint8_t>(MessageType::Hello)) {
+        return std::nullopt;
+    }
+
+    WireHeader header;
+    header.type = static_cast<MessageType>(bytes[1]);
+    header.flags = static_cast<std::uint16_t>(bytes[2] | (bytes[3] << 8));
+    for (std::size_t i = 0; i < 8; ++i) {
+        header.correlation_id |= static_cast<CorrelationId>(bytes[4 + i]) << (8 * i);
+    }
+    return header;
+}
+
+inline std::array<std::uint8_t, kTraceFrameSize> EncodeTraceFrame(TraceId trace_id) noexcept {
+    std::array<std::uint8_t, kTraceFrameSize> bytes{};
+    for (std::size_t i = 0; i < kTraceFrameSize; ++i) {
+        bytes[i] = static_cast<std::uint8_t>(trace_id >> (8 * i));
+    }
+    return bytes;
+}
+
+// 0 for a malformed frame, which leaves the question untraced.
+inline TraceId DecodeTraceFrame(const void* data, std::size_t size) noexcept {
+    if (size != kTraceFrameSize) {
+        return 0;
+    }
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    TraceId trace_id = 0;
+    for (std::size_t i = 0; i < kTraceFrameSize; ++i) {
+        trace_id |= static_cast<TraceId>(bytes[i]) << (8 * i);
+    }
+    return trace_id;
+}
+
+inline void AppendBatchRecord(std::string& records, std::string_view content_type, std::string_view content) {
+    const auto content_type_size = static_cast<std::uint16_t>(content_type.size());
+    const auto content_size = static_cast<std::uint32_t>(content.size());
+    const char prefix[2] = {static_cast<char>(content_type_size), static_cast<char>(content_type_size >> 8)};
+    records.append(prefix, sizeof(prefix));
+    records.append(content_type.data(), content_type_size);
+    char length[4];
+    for (std::size_t i = 0; i < 4; ++i) {
+        length[i] = static_cast<char>(content_size >> (8 * i));
+    }
+    records.append(length, sizeof(length));
+    records.append(content);
+}
+
+// Calls visit(content_type, content) for every record. Returns false, after
+// the records that did decode, if the frame is truncated.
+template <typename Visitor>
+bool ForEachBatchRecord(std::string_view records, Visitor&& visit) {
+    const auto read = [&records](std::size_t bytes) {
+        std::uint32_t value = 0;
+        for (std::size_t i = 0; i < bytes; ++i) {
+            value |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(records[i])) << (8 * i);
+        }
+        records.remove_prefix(bytes);
+        return value;
+    };
+
+    while (!records.empty()) {
+        if (records.size() < 2) {
+            return false;
+        }
+        const auto content_type_size = read(2);
+        if (records.size() < content_type_size + 4) {
+            return false;
+        }
+        const auto content_type = records.substr(0, content_type_size);
+        records.remove_prefix(content_type_size);
+        const auto content_size = read(4);
+        if (records.size() < content_size) {
+            return false;
+        }
+        visit(content_type, records.substr(0, content_size));
+        records.remove_prefix(content_size);
+    }
+    return true;
+}
+
+inline bool IsBinaryPeerIdentity(std::string_view identity) noexcept {
+    return identity.starts_with(kBinaryPeerIdentityPrefix);
+}
+
+// Text peers carry correlation ids as strings; native ids travel as 16 hex chars.
+inline std::string FormatCorrelationId(CorrelationId value) {
+    constexpr char digits[] = "0123456789abcdef";
+    std::string result(16, '0');
+    for (int i = 15; i >= 0; --i) {
+        result[i] = digits[value & 0xF];
+        value >>= 4;
+    }
+    return result;
+}
+
+inline std::optional<CorrelationId> ParseCorrelationId(std::string_view value) noexcept {
+    if (value.size() != 16) {
+        return std::nullopt;
+    }
+
+    CorrelationId result = 0;
+    for (const char c : value) {
+        result <<= 4;
+        if (c >= '0' && c <= '9') {
+            result |= static_cast<CorrelationId>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            result |= static_cast<CorrelationId>(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            result |= static_cast<CorrelationId>(c - 'A' + 10);
+        } else {
+            return std::nullopt;
+        }
+    }
+    return result;
+}
+
+} // namespace minx::zmesh
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "executor.hpp"
+
+namespace minx::zmesh {
+
+// Thread pool with one task deque per worker. Tasks posted from a worker stay
+// on that worker's deque; tasks posted from elsewhere are spread round-robin.
+// Idle workers steal from the back of the other deques before going to sleep.
+class WorkStealingExecutor final : public Executor {
+public:
+    explicit WorkStealingExecutor(std::size_t thread_count = std::thread::hardware_concurrency(),
+                                  ErrorHandler on_error = {});
+    ~WorkStealingExecutor() override;
+
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+    void Post(Task task) override;
+
+    // Drops queued tasks and joins the workers; later posts are ignored.
+    void Stop();
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::jthread thread;
+    };
+
+    bool TryTake(std::size_t index, Task& task);
+    void Run(std::size_t index, std::stop_token stop_token);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<std::size_t> next_worker_{0};
+    // Signed: a task can be taken before its post has counted it.
+    std::atomic<std::int64_t> queued_{0};
+    std::atomic<std::size_t> sleepers_{0};
+    std::atomic<bool> stopped_{false};
+
+    std::mutex sleep_mutex_;
+    std::condition_variable_any sleep_cv_;
+};
+
+} // namespace minx::zmesh
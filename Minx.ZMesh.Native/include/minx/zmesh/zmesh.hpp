@@ -1,48 +1,161 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <ostream>
+#include <shared_mutex>
 #include <string>
-#include <thread>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <zmq.hpp>
 
 #include "abstract_message_box.hpp"
+#include "compressor.hpp"
+#include "content_type.hpp"
+#include "executor.hpp"
+#include "frame_writer.hpp"
+#include "message_inbox.hpp"
+#include "metrics.hpp"
+#include "pending_chunk.hpp"
+#include "reactor.hpp"
+#include "router_pipeline.hpp"
+#include "timer_wheel.hpp"
+#include "tracing.hpp"
+#include "wire_format.hpp"
+#include "work_stealing_executor.hpp"
+#include "zmesh_options.hpp"
 
 namespace minx::zmesh {
 
+// Content type names received from a mesh's peers are interned only up to
+// ContentType::kMaxPeerContentTypes new names per mesh; past that, Tells of a
+// type this process has never constructed are dropped and such Asks from
+// native peers are rejected. Both count in MeshMetrics::content_types_refused.
 class ZMesh {
 public:
+    // Addresses, the bind address and the system map's, are ZeroMQ endpoint
+    // URIs or bare host:port pairs for TCP; see ToEndpoint().
     ZMesh(std::optional<std::string> address,
-          std::unordered_map<std::string, std::string> system_map);
+          std::unordered_map<std::string, std::string> system_map,
+          ZMeshOptions options = {});
     ~ZMesh();
 
     std::shared_ptr<IAbstractMessageBox> At(const std::string& name);
 
+    // Counters, queue depths and latency histograms of the mesh and of every
+    // box and inbox it holds, read without stopping traffic.
+    MeshMetrics GetMetrics();
+
+    // Writes the events of sampled Asks (ZMeshOptions::tracing) that the
+    // flight recorder still holds.
+    void DumpTrace(std::ostream& out, TraceFormat format = TraceFormat::ChromeTrace) const;
+
 private:
-    void RouterLoop(std::stop_token stop_token);
-    void DispatchTell(const std::string& message_box_name,
-                      const std::string& content_type,
-                      const std::string& content);
-    void DispatchQuestion(const std::string& dealer_identity,
-                          const std::string& message_box_name,
-                          const std::string& correlation_id,
-                          const std::string& content_type,
-                          const std::string& content);
-    void SendPendingAnswers();
-
-    zmq::context_t context_;
+    // Lets the string-keyed sets and maps below be searched with a string_view.
+    struct StringHash {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view value) const noexcept {
+            return std::hash<std::string_view>{}(value);
+        }
+    };
+
+    // Unsent messages of a peer whose pipe is full, retried with a delay that
+    // doubles each time the pipe is still full.
+    struct BlockedPeer {
+        using Duration = std::chrono::steady_clock::duration;
+
+        FrameWriter frames;
+        Duration retry_delay;
+        std::chrono::steady_clock::time_point retry_at;
+    };
+
+    void ReceiveFromRouter(zmq::socket_t& router);
+    void DispatchFrames(RouterFrames& message);
+    void DispatchTell(std::string_view message_box_name,
+                      ContentType content_type,
+                      Payload content);
+    // Null if the content is compressed and fails to decompress.
+    std::optional<Payload> ReceiveContent(const WireHeader& header,
+                                          ContentType content_type,
+                                          zmq::message_t&& frame) const;
+    void DispatchTellBatch(std::string_view message_box_name, zmq::message_t&& records);
+    void DispatchChunk(std::string_view message_box_name, PendingChunk pending_chunk);
+    void DispatchQuestion(const std::string& dealer_identity, QuestionMessage question_message);
+    // Answers a binary peer's Ask that never reached an inbox.
+    void RejectQuestion(std::string dealer_identity,
+                        std::string message_box_name,
+                        CorrelationId correlation_id,
+                        std::string reason);
+    // Greets a native dealer the router does not remember.
+    void GreetBinaryPeer(zmq::socket_t& router, std::string_view dealer_identity);
+    void SendHello(zmq::socket_t& router, const std::string& dealer_identity);
+    void SendPendingAnswers(zmq::socket_t& router);
+    // Where the next message to a peer is added: its backlog while its pipe
+    // is full, router_frames_ otherwise.
+    FrameWriter& PeerFrames(std::string_view dealer_identity);
+    // Puts router_frames_, holding one message to the peer, on the wire. If the
+    // peer's pipe is full the message becomes its backlog.
+    void SendToPeer(zmq::socket_t& router, std::string_view dealer_identity);
+    // Retries the backlogs that are due and schedules the next retry.
+    void SendBlockedPeers(zmq::socket_t& router);
+    // Interns a name received from a peer against this mesh's budget; null,
+    // and counted, once the budget is spent.
+    std::optional<ContentType> PeerContentType(std::string_view name);
+    // Null for names missing from the system map.
+    std::shared_ptr<MessageInbox> FindOrCreateInbox(std::string_view name);
+
+    std::shared_ptr<zmq::context_t> context_;
+    // Endpoint the router is bound to; empty when the mesh hosts no boxes.
+    // Boxes mapped to it are local.
+    std::string endpoint_;
     std::unordered_map<std::string, std::string> system_map_;
+    ZMeshOptions options_;
+    Compressor compressor_;
+    std::shared_ptr<FlightRecorder> recorder_;
 
+    TimerWheel timers_;
+    std::shared_ptr<WorkStealingExecutor> owned_executor_;
+    std::shared_ptr<Executor> executor_;
+    std::unique_ptr<Reactor> reactor_;
     std::shared_ptr<AnswerQueue> answer_queue_;
+    std::optional<Reactor::ChannelId> router_channel_;
+    // The message being sent through the router, and the unsent messages of
+    // peers whose pipe is full; receiving thread only.
+    FrameWriter router_frames_;
+    std::unordered_map<std::string, BlockedPeer, StringHash, std::equal_to<>> blocked_peers_;
+    // Set when router_workers is non-zero; otherwise the reactor dispatches.
+    std::unique_ptr<RouterPipeline> pipeline_;
+    // Dealers already greeted with a binary Hello, in two generations. Peers
+    // heard from again move to the current one; when a new generation starts,
+    // the previous one is forgotten. Receiving thread only.
+    std::unordered_set<std::string, StringHash, std::equal_to<>> binary_peers_;
+    std::unordered_set<std::string, StringHash, std::equal_to<>> previous_binary_peers_;
+    std::chrono::steady_clock::time_point binary_peers_since_{std::chrono::steady_clock::now()};
+    std::atomic<std::size_t> binary_peer_count_{0};
 
-    std::unique_ptr<zmq::socket_t> router_;
-    std::jthread router_thread_;
+    // Requests taken off the router and answers sent back through it.
+    std::atomic<std::uint64_t> messages_received_{0};
+    std::atomic<std::uint64_t> answers_sent_{0};
+    // New content type names this mesh's peers have interned, and messages
+    // refused once that reached ContentType::kMaxPeerContentTypes.
+    std::atomic<std::size_t> peer_content_types_{0};
+    std::atomic<std::uint64_t> content_types_refused_{0};
 
     std::mutex message_boxes_mutex_;
     std::unordered_map<std::string, std::shared_ptr<AbstractMessageBox>> message_boxes_;
+
+    // Receiving side of every box that messages arrived for or At() returned.
+    std::shared_mutex inboxes_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<MessageInbox>, StringHash, std::equal_to<>> inboxes_;
 };
 
 } // namespace minx::zmesh
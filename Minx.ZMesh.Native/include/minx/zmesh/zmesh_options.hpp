@@ -0,0 +1,151 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <zmq.hpp>
+
+#include "bounded_queue.hpp"
+#include "error_handler.hpp"
+#include "executor.hpp"
+
+namespace minx::zmesh {
+
+enum class QueueKind {
+    // ThreadSafeQueue: std::deque behind a mutex.
+    Locked,
+    // MpscQueue: lock-free ring with a locked overflow list.
+    LockFree
+};
+
+enum class CompressionAlgorithm {
+    None,
+    // Fast, modest ratio; for large payloads on a busy link.
+    Lz4,
+    // Slower, better ratio; with a dictionary also for small payloads.
+    Zstd
+};
+
+// Compression of one content type's payloads sent to native peers. The header
+// says how a payload was compressed, so receivers need no entry of their own
+// unless a zstd dictionary is used, which both sides must share.
+struct CompressionOptions {
+    CompressionAlgorithm algorithm = CompressionAlgorithm::None;
+    // Smaller payloads are sent as they are.
+    std::size_t min_size = 1024;
+    // zstd level, or the LZ4 acceleration; 0 picks the library default.
+    int level = 0;
+    std::shared_ptr<const std::string> dictionary;
+};
+
+// Packs the Tells a dealer has queued for a box into one batched message
+// (see kWireFlagBatch). A batch goes out once it holds max_messages Tells or
+// max_bytes, or max_delay after its first Tell; with a zero max_delay it goes
+// out as soon as the queued messages are drained. Tells of max_bytes or more
+// are sent on their own. Only native peers receive batches.
+struct TellBatching {
+    // 0 disables batching.
+    std::size_t max_messages = 0;
+    std::size_t max_bytes = 64 * 1024;
+    std::chrono::microseconds max_delay{0};
+};
+
+// Streamed Tells (TellStream) go out in chunk_size chunks, interleaved with
+// the box's other messages. At most window chunks per stream are unhandled by
+// the receiver at a time, which bounds the memory a stream holds on both ends.
+// A peer that has been sent something identifies as native within
+// hello_timeout or is taken for a text peer; its streams wait until then.
+// Streams to a peer of unknown format that has been sent nothing go as one
+// Tell, which native routers still hand to ListenStream() handlers.
+struct StreamOptions {
+    std::size_t chunk_size = 256 * 1024;
+    std::size_t window = 8;
+    std::chrono::milliseconds hello_timeout{1000};
+};
+
+// Sampled tracing of Asks into the mesh's FlightRecorder; see ZMesh::DumpTrace.
+// Questions to native peers carry the trace id, so the answering mesh records
+// its stages of a sampled Ask whatever its own sample_every.
+struct TracingOptions {
+    // Trace every sample_every-th Ask; 0 disables sampling.
+    std::uint32_t sample_every = 0;
+    // Events kept per recording thread, rounded up to a power of two.
+    std::size_t ring_capacity = 4096;
+};
+
+struct ZMeshOptions {
+    // ZeroMQ context of the mesh's sockets. When empty the mesh owns one;
+    // meshes that reach each other over inproc:// endpoints must share it.
+    std::shared_ptr<zmq::context_t> context;
+
+    // Number of reactor threads polling the router and all dealer sockets.
+    std::size_t reactor_threads = 1;
+
+    // Upper bound on open ZeroMQ sockets (ZMQ_MAX_SOCKETS). Every remote
+    // message box owns one dealer socket; 0 keeps the libzmq default. Only
+    // applied to a context the mesh owns.
+    int max_sockets = 0;
+
+    // Threads that decode received messages and dispatch them into inboxes.
+    // With 0 the reactor thread that receives them does it; otherwise it only
+    // reads frames and hands them to the workers through SPSC rings of
+    // router_ring_capacity messages each. Messages for one box always go to the
+    // same worker, so their order is kept.
+    std::size_t router_workers = 0;
+    std::size_t router_ring_capacity = 1024;
+
+    // Queue used where many threads feed one reactor channel: each dealer's
+    // outgoing messages and the shared answer queue.
+    QueueKind single_consumer_queue = QueueKind::LockFree;
+
+    // Default limit of every inbox queue, i.e. the messages, questions and
+    // stream chunks of one content type waiting for TryListen()/TryAnswer() or
+    // a handler; boxes can override it per content type. Block stalls the reactor thread that receives for
+    // this mesh, which pushes back on senders through ZeroMQ's high-water marks;
+    // senders in this process that Tell a local box are stalled directly.
+    // Questions dropped or refused under the other policies are rejected, and
+    // a stream that loses a chunk ends aborted once its last chunk arrives.
+    QueueLimit inbox_limit;
+
+    // Limit of each box's outgoing queue. Block stalls the Tell()/Ask() caller,
+    // so it must not be used from reactor threads (e.g. AskAsync continuations
+    // without resume_on). A capacity replaces single_consumer_queue with a
+    // BoundedQueue for these queues. The capacity also caps the answers held
+    // back for a peer whose pipe is full; past it they are dropped.
+    QueueLimit outgoing_limit;
+
+    TellBatching tell_batching;
+    StreamOptions streams;
+
+    // The router remembers which native dealers it has greeted with a Hello.
+    // One not heard from for at least peer_idle_timeout is forgotten once
+    // other dealers connect, so reconnecting dealers do not pile up; if it
+    // comes back it is greeted again.
+    std::chrono::milliseconds peer_idle_timeout{std::chrono::minutes{1}};
+
+    // Keyed by content type name. Tells that get compressed are never batched.
+    std::unordered_map<std::string, CompressionOptions> compression;
+
+    TracingOptions tracing;
+
+    // Runs handlers registered with Listen()/Respond(). When empty the mesh
+    // owns a work-stealing pool of handler_threads threads. A supplied
+    // executor must be drained or stopped before the ZMesh is destroyed.
+    std::shared_ptr<Executor> handler_executor;
+    std::size_t handler_threads = 1;
+
+    // Receives exceptions with no caller to report them to. A reactor channel
+    // whose socket fails is closed and its error passed here; the pending Asks
+    // of its box fail with the same exception. So are exceptions thrown by
+    // handlers on the mesh's own executor; a supplied executor reports to its
+    // own handler. TellStream sources that throw are reported here too; their
+    // stream ends early. So are messages the router pipeline's workers fail to
+    // dispatch. Without a handler they are written to stderr.
+    ErrorHandler on_error;
+};
+
+} // namespace minx::zmesh
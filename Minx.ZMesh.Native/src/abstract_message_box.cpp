@@ -1,29 +1,27 @@
 #include "minx/zmesh/abstract_message_box.hpp"
 
 #include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
+#include "minx/zmesh/endpoint.hpp"
+#include "minx/zmesh/pending_chunk.hpp"
 #include "minx/zmesh/pending_question.hpp"
 #include "minx/zmesh/types.hpp"
+#include "minx/zmesh/wire_format.hpp"
 
 namespace minx::zmesh {
 
 namespace {
 
-void EnsureSend(zmq::socket_t& socket,
-                const zmq::const_buffer& buffer,
-                zmq::send_flags flags,
-                std::string_view operation) {
-    const auto sent = socket.send(buffer, flags);
-    if (!sent) {
-        throw std::runtime_error("ZeroMQ send failed during " + std::string(operation));
-    }
-}
-
 void EnsureRecv(zmq::socket_t& socket,
                 zmq::message_t& frame,
                 std::string_view operation,
@@ -34,6 +32,21 @@ void EnsureRecv(zmq::socket_t& socket,
     }
 }
 
+template <std::size_t N>
+std::size_t RecvMultipart(zmq::socket_t& socket, std::array<zmq::message_t, N>& frames, std::string_view operation) {
+    // Frames beyond N are drained and dropped so the next read starts clean.
+    std::size_t count = 0;
+    zmq::message_t discarded;
+    for (;;) {
+        auto& frame = count < N ? frames[count] : discarded;
+        EnsureRecv(socket, frame, operation);
+        ++count;
+        if (!frame.more()) {
+            return count;
+        }
+    }
+}
+
 std::string FrameToString(const zmq::message_t& frame, bool trim_nulls = true) {
     std::string value(static_cast<const char*>(frame.data()), frame.size());
     if (trim_nulls) {
@@ -44,310 +57,793 @@ std::string FrameToString(const zmq::message_t& frame, bool trim_nulls = true) {
     return value;
 }
 
+// Stream ids only have to be unique per receiving box; random ones need no
+// coordination between senders.
+CorrelationId NextStreamId() {
+    thread_local std::mt19937_64 random_engine(std::random_device{}());
+    return random_engine();
+}
+
 } // namespace
 
 AbstractMessageBox::AbstractMessageBox(std::string name,
                                        std::string address,
                                        zmq::context_t& context,
-                                       std::shared_ptr<AnswerQueue> answer_queue)
+                                       Reactor& reactor,
+                                       TimerWheel& timers,
+                                       std::shared_ptr<MessageInbox> inbox,
+                                       const Compressor& compressor,
+                                       std::shared_ptr<FlightRecorder> recorder,
+                                       QueueKind outgoing_queue_kind,
+                                       QueueLimit outgoing_limit,
+                                       TellBatching tell_batching,
+                                       StreamOptions streams_options,
+                                       bool local,
+                                       ErrorHandler on_error)
     : name_(std::move(name)),
       address_(std::move(address)),
       context_(context),
-      answer_queue_(std::move(answer_queue)),
-      dealer_(context_, zmq::socket_type::dealer) {
-    dealer_.set(zmq::sockopt::linger, 0);
+      reactor_(reactor),
+      timers_(timers),
+      inbox_(std::move(inbox)),
+      compressor_(compressor),
+      recorder_(std::move(recorder)),
+      local_(local),
+      on_error_(std::move(on_error)),
+      outgoing_messages_([this] { reactor_.Schedule(*dealer_channel_); }, outgoing_queue_kind, outgoing_limit),
+      tell_batching_(tell_batching),
+      streams_options_(streams_options) {}
 
-    std::random_device rd;
-    {
-        std::lock_guard random_lock(random_mutex_);
-        random_engine_.seed(rd());
+AbstractMessageBox::~AbstractMessageBox() {
+    outgoing_messages_.close();
+    // The last reference may be dropped on another reactor thread or the timer
+    // thread, which the dealer's thread could be waiting on, so the dealer is
+    // closed without waiting. Its handlers only hold a weak reference.
+    if (dealer_channel_) {
+        reactor_.Detach(*dealer_channel_);
     }
 
-    dealer_.set(zmq::sockopt::routing_id, GenerateCorrelationId());
-
-    dealer_.connect("tcp://" + address_);
-
-    dealer_thread_ = std::jthread([this](std::stop_token stop_token) { DealerLoop(stop_token); });
+    const auto error = std::make_exception_ptr(std::runtime_error("Message box disposed"));
+    for (auto& pending_answer : pending_answers_.TakeAll()) {
+        timers_.Cancel(pending_answer.timeout_timer);
+        pending_answer.Reject(error);
+    }
 }
 
-AbstractMessageBox::~AbstractMessageBox() {
-    outgoing_messages_.close();
+void AbstractMessageBox::Tell(ContentType content_type, std::string content) {
+    Tell(content_type, Payload(std::move(content)));
+}
 
-    if (dealer_thread_.joinable()) {
-        dealer_thread_.request_stop();
-        dealer_thread_.join();
+void AbstractMessageBox::Tell(ContentType content_type, Payload content) {
+    if (local_) {
+        tells_sent_.fetch_add(1, std::memory_order_relaxed);
+        inbox_->ReceiveTell(content_type, std::move(content));
+        return;
     }
 
-    try {
-        dealer_.close();
-    } catch (...) {
-    }
+    OutgoingMessage message =
+        TellMessage{.message_box_name = name_, .content_type = content_type, .content = std::move(content)};
+    ThrowIfNotQueued(EnqueueOutgoing(message));
+}
+
+void AbstractMessageBox::TellStream(ContentType content_type, Payload content) {
+    const auto chunk_size = std::max<std::size_t>(streams_options_.chunk_size, 1);
+    TellStream(content_type, [content = std::move(content), chunk_size, offset = std::size_t{0}]() mutable {
+        const auto size = std::min(chunk_size, content.size() - offset);
+        Payload chunk(content.owner(), content.view().substr(offset, size));
+        offset += size;
+        return chunk;
+    });
+}
 
-    std::lock_guard lock(pending_answers_mutex_);
-    for (auto& [id, promise] : pending_answers_) {
-        try {
-            throw std::runtime_error("Message box disposed");
-        } catch (...) {
-            promise->set_exception(std::current_exception());
+void AbstractMessageBox::TellStream(ContentType content_type, StreamSource source) {
+    if (local_) {
+        // No window here: the chunks go straight into the inbox.
+        streams_sent_.fetch_add(1, std::memory_order_relaxed);
+        const auto stream_id = NextStreamId();
+        const auto deliver = [&](Payload content, bool last, bool aborted) {
+            chunks_sent_.fetch_add(1, std::memory_order_relaxed);
+            inbox_->ReceiveChunk(PendingChunk{.dealer_identity = {},
+                                              .stream_id = stream_id,
+                                              .content_type = content_type,
+                                              .content = std::move(content),
+                                              .last = last,
+                                              .aborted = aborted,
+                                              .answer_queue = nullptr});
+        };
+        auto chunk = source();
+        for (;;) {
+            Payload next;
+            if (!chunk.empty()) {
+                try {
+                    next = source();
+                } catch (...) {
+                    // The handler sees the stream end early; the caller gets the error.
+                    deliver(std::move(chunk), false, false);
+                    deliver(Payload{}, true, true);
+                    throw;
+                }
+            }
+            const bool last = next.empty();
+            deliver(std::move(chunk), last, false);
+            if (last) {
+                return;
+            }
+            chunk = std::move(next);
         }
     }
-    pending_answers_.clear();
+
+    OutgoingMessage message =
+        StreamMessage{.message_box_name = name_, .content_type = content_type, .source = std::move(source)};
+    ThrowIfNotQueued(EnqueueOutgoing(message));
 }
 
-void AbstractMessageBox::Tell(std::string content_type, std::string content) {
-    outgoing_messages_.push(TellMessage{.message_box_name = name_,
-                                        .content_type = std::move(content_type),
-                                        .content = std::move(content)});
+void AbstractMessageBox::ListenStream(ContentType content_type, TellStreamHandler handler) {
+    inbox_->ListenStream(content_type, std::move(handler));
 }
 
-bool AbstractMessageBox::TryListen(const std::string& content_type, const TellHandler& handler) {
-    auto queue = GetOrCreateMessageQueue(content_type);
-    std::string message;
-    if (!queue->try_pop(message)) {
-        return false;
-    }
-    handler(message);
-    return true;
+void AbstractMessageBox::Listen(ContentType content_type, TellViewHandler handler, HandlerOptions options) {
+    inbox_->Listen(content_type, std::move(handler), options);
 }
 
-std::future<Answer> AbstractMessageBox::Ask(const std::string& content_type) {
-    return InternalAsk(content_type, std::nullopt, std::nullopt);
+void AbstractMessageBox::Respond(ContentType question_content_type,
+                                 QuestionViewHandler handler,
+                                 HandlerOptions options) {
+    inbox_->Respond(question_content_type, std::move(handler), options);
 }
 
-std::future<Answer> AbstractMessageBox::Ask(const std::string& content_type, std::string content) {
-    return InternalAsk(content_type, std::move(content), std::nullopt);
+bool AbstractMessageBox::TryListen(ContentType content_type, const TellHandler& handler) {
+    return inbox_->TryListen(content_type, handler);
+}
+
+bool AbstractMessageBox::TryListenView(ContentType content_type, const TellViewHandler& handler) {
+    return inbox_->TryListenView(content_type, handler);
+}
+
+std::size_t AbstractMessageBox::TryListenBatch(ContentType content_type,
+                                               std::size_t max_messages,
+                                               const TellBatchHandler& handler) {
+    return inbox_->TryListenBatch(content_type, max_messages, handler);
 }
 
-std::future<Answer> AbstractMessageBox::Ask(const std::string& content_type, std::chrono::milliseconds timeout) {
-    return InternalAsk(content_type, std::nullopt, timeout);
+std::future<Answer> AbstractMessageBox::Ask(ContentType content_type) {
+    return InternalAsk(content_type, Payload{}, std::nullopt);
 }
 
-std::future<Answer> AbstractMessageBox::Ask(const std::string& content_type,
+std::future<Answer> AbstractMessageBox::Ask(ContentType content_type, std::string content) {
+    return InternalAsk(content_type, Payload(std::move(content)), std::nullopt);
+}
+
+std::future<Answer> AbstractMessageBox::Ask(ContentType content_type, std::chrono::milliseconds timeout) {
+    return InternalAsk(content_type, Payload{}, timeout);
+}
+
+std::future<Answer> AbstractMessageBox::Ask(ContentType content_type,
                                             std::string content,
                                             std::chrono::milliseconds timeout) {
+    return InternalAsk(content_type, Payload(std::move(content)), timeout);
+}
+
+std::future<Answer> AbstractMessageBox::Ask(ContentType content_type, Payload content) {
+    return InternalAsk(content_type, std::move(content), std::nullopt);
+}
+
+std::future<Answer> AbstractMessageBox::Ask(ContentType content_type,
+                                            Payload content,
+                                            std::chrono::milliseconds timeout) {
     return InternalAsk(content_type, std::move(content), timeout);
 }
 
-bool AbstractMessageBox::TryAnswer(const std::string& question_content_type, const QuestionHandler& handler) {
-    auto queue = GetOrCreatePendingQueue(question_content_type);
-    PendingQuestion pending_question;
-    if (!queue->try_pop(pending_question)) {
-        return false;
-    }
+bool AbstractMessageBox::TryAnswer(ContentType question_content_type, const QuestionHandler& handler) {
+    return inbox_->TryAnswer(question_content_type, handler);
+}
 
-    Answer answer = handler(pending_question.question_message.content);
-    SendAnswer(pending_question, answer);
+bool AbstractMessageBox::TryAnswerView(ContentType question_content_type, const QuestionViewHandler& handler) {
+    return inbox_->TryAnswerView(question_content_type, handler);
+}
 
-    return true;
+std::size_t AbstractMessageBox::TryAnswerBatch(ContentType question_content_type,
+                                               std::size_t max_questions,
+                                               const QuestionBatchHandler& handler) {
+    return inbox_->TryAnswerBatch(question_content_type, max_questions, handler);
 }
 
-std::optional<PendingQuestion> AbstractMessageBox::GetQuestion(const std::string& question_type) {
-    auto queue = GetOrCreatePendingQueue(question_type);
-    PendingQuestion pending_question;
-    if (!queue->try_pop(pending_question)) {
-        return std::nullopt;
-    }
-    return pending_question;
+std::optional<PendingQuestion> AbstractMessageBox::GetQuestion(ContentType question_type) {
+    return inbox_->GetQuestion(question_type);
 }
 
-void AbstractMessageBox::ReceiveTell(const TellMessage& message) {
-    auto queue = GetOrCreateMessageQueue(message.content_type);
-    queue->push(message.content);
+void AbstractMessageBox::SetInboxLimit(QueueLimit limit) {
+    inbox_->SetInboxLimit(limit);
 }
 
-void AbstractMessageBox::ReceiveQuestion(const PendingQuestion& pending_question) {
-    auto queue = GetOrCreatePendingQueue(pending_question.question_message.content_type);
-    queue->push(pending_question);
+void AbstractMessageBox::SetInboxLimit(ContentType content_type, QueueLimit limit) {
+    inbox_->SetInboxLimit(content_type, limit);
 }
 
-void AbstractMessageBox::ReceiveAnswer(const AnswerMessage& message) {
-    FulfillPendingAnswer(message.correlation_id, Answer{message.content_type, message.content});
+QueueCounters AbstractMessageBox::GetInboxCounters(ContentType content_type) {
+    return inbox_->GetInboxCounters(content_type);
 }
 
-std::shared_ptr<ThreadSafeQueue<std::string>>
-AbstractMessageBox::GetOrCreateMessageQueue(const std::string& content_type) {
-    std::lock_guard lock(messages_mutex_);
-    auto it = messages_.find(content_type);
-    if (it == messages_.end()) {
-        auto queue = std::make_shared<ThreadSafeQueue<std::string>>();
-        it = messages_.emplace(content_type, std::move(queue)).first;
+void AbstractMessageBox::ReceiveAnswer(AnswerMessage message) {
+    if (message.rejected) {
+        FailPendingAnswer(message.correlation_id, std::make_exception_ptr(std::runtime_error(message.content)));
+        return;
     }
-    return it->second;
+    FulfillPendingAnswer(message.correlation_id, Answer{std::move(message.content_type), std::move(message.content)});
 }
 
-std::shared_ptr<ThreadSafeQueue<PendingQuestion>>
-AbstractMessageBox::GetOrCreatePendingQueue(const std::string& content_type) {
-    std::lock_guard lock(pending_questions_mutex_);
-    auto it = pending_questions_.find(content_type);
-    if (it == pending_questions_.end()) {
-        auto queue = std::make_shared<ThreadSafeQueue<PendingQuestion>>();
-        it = pending_questions_.emplace(content_type, std::move(queue)).first;
-    }
-    return it->second;
+QueueCounters AbstractMessageBox::GetOutgoingCounters() {
+    return outgoing_messages_.counters();
 }
 
-std::future<Answer> AbstractMessageBox::InternalAsk(const std::string& content_type,
-                                                    std::optional<std::string> content,
-                                                    std::optional<std::chrono::milliseconds> timeout) {
-    const auto correlation_id = GenerateCorrelationId();
-    QuestionMessage message{.message_box_name = name_,
-                            .correlation_id = correlation_id,
-                            .content_type = content_type,
-                            .content = content.value_or("")};
+MessageBoxMetrics AbstractMessageBox::GetMetrics() {
+    return MessageBoxMetrics{.message_box = name_,
+                             .tells_sent = tells_sent_.load(std::memory_order_relaxed),
+                             .questions_sent = questions_sent_.load(std::memory_order_relaxed),
+                             .streams_sent = streams_sent_.load(std::memory_order_relaxed),
+                             .chunks_sent = chunks_sent_.load(std::memory_order_relaxed),
+                             .answers_received = answers_received_.load(std::memory_order_relaxed),
+                             .asks_timed_out = asks_timed_out_.load(std::memory_order_relaxed),
+                             .asks_failed = asks_failed_.load(std::memory_order_relaxed),
+                             .pending_answers = pending_answers_.size(),
+                             .outgoing_depth = outgoing_depth_.load(std::memory_order_relaxed),
+                             .outgoing = outgoing_messages_.counters(),
+                             .ask_rtt = ask_rtt_.Snapshot(),
+                             .enqueue_to_send = enqueue_to_send_.Snapshot()};
+}
 
+std::future<Answer> AbstractMessageBox::InternalAsk(ContentType content_type,
+                                                    Payload content,
+                                                    std::optional<std::chrono::milliseconds> timeout) {
     auto promise = std::make_shared<std::promise<Answer>>();
     auto future = promise->get_future();
-    {
-        std::lock_guard lock(pending_answers_mutex_);
-        pending_answers_[correlation_id] = promise;
+    SendQuestion(PendingAnswer{.promise = std::move(promise)}, content_type, std::move(content), timeout);
+    return future;
+}
+
+AskAwaitable AbstractMessageBox::AskAsync(ContentType content_type, Payload content, AskOptions options) {
+    return AskAwaitable(shared_from_this(), content_type, std::move(content), options);
+}
+
+void AbstractMessageBox::StartAsk(AskAwaitable& awaiter) {
+    SendQuestion(PendingAnswer{.awaiter = awaiter.state_},
+                 awaiter.content_type_,
+                 std::move(awaiter.content_),
+                 awaiter.options_.timeout);
+}
+
+void AbstractMessageBox::CancelAsk(CorrelationId correlation_id) {
+    if (auto pending_answer = pending_answers_.Take(correlation_id)) {
+        timers_.Cancel(pending_answer->timeout_timer);
     }
+}
 
-    outgoing_messages_.push(message);
+void AbstractMessageBox::SendQuestion(PendingAnswer pending_answer,
+                                      ContentType content_type,
+                                      Payload content,
+                                      std::optional<std::chrono::milliseconds> timeout) {
+    const auto trace_id = recorder_->Sample();
+    pending_answer.asked_at = std::chrono::steady_clock::now();
+    pending_answer.trace_id = trace_id;
+    const auto awaiter = pending_answer.awaiter;
+    const auto correlation_id = pending_answers_.Insert(std::move(pending_answer));
+    if (awaiter) {
+        // Set before the question can be answered or time out.
+        awaiter->correlation_id.store(correlation_id, std::memory_order_release);
+    }
 
     if (timeout) {
-        auto weak_promise = std::weak_ptr(promise);
-        std::thread([this, weak_promise, correlation_id, timeout_value = *timeout]() {
-            std::this_thread::sleep_for(timeout_value);
-            if (auto locked = weak_promise.lock()) {
-                std::lock_guard lock(pending_answers_mutex_);
-                auto it = pending_answers_.find(correlation_id);
-                if (it != pending_answers_.end()) {
-                    try {
-                        throw std::runtime_error("Request timed out");
-                    } catch (...) {
-                        it->second->set_exception(std::current_exception());
-                    }
-                    pending_answers_.erase(it);
+        const auto timer = timers_.Schedule(*timeout, [weak_self = weak_from_this(), correlation_id]() {
+            if (auto self = weak_self.lock()) {
+                self->FailPendingAnswer(
+                    correlation_id, std::make_exception_ptr(std::runtime_error("Request timed out")), true);
+            }
+        });
+        pending_answers_.Update(correlation_id, [timer](PendingAnswer& entry) { entry.timeout_timer = timer; });
+    }
+
+    QuestionMessage question{.message_box_name = name_,
+                             .correlation_id = correlation_id,
+                             .content_type = content_type,
+                             .content = std::move(content),
+                             .trace_id = trace_id};
+
+    recorder_->Record(trace_id, TraceStage::Enqueued);
+    if (local_) {
+        questions_sent_.fetch_add(1, std::memory_order_relaxed);
+        inbox_->ReceiveQuestion(PendingQuestion{
+            .dealer_identity = {},
+            .question_message = std::move(question),
+            .answer_queue = nullptr,
+            .local_reply = [weak_self = weak_from_this()](AnswerMessage answer) {
+                if (auto self = weak_self.lock()) {
+                    self->ReceiveAnswer(std::move(answer));
                 }
+            },
+            .recorder = trace_id != 0 ? recorder_ : nullptr});
+        return;
+    }
+
+    OutgoingMessage message = std::move(question);
+    const auto result = EnqueueOutgoing(message);
+    if (result == PushResult::DroppedNewest || result == PushResult::Rejected) {
+        FailPendingAnswer(correlation_id,
+                          std::make_exception_ptr(std::runtime_error("Outgoing queue of " + name_ + " is full")));
+    } else if (result == PushResult::Closed) {
+        FailPendingAnswer(correlation_id,
+                          std::make_exception_ptr(std::runtime_error("Dealer of " + name_ + " has failed")));
+    }
+}
+
+void AbstractMessageBox::OpenDealer() {
+    zmq::socket_t dealer(context_, zmq::socket_type::dealer);
+    dealer.set(zmq::sockopt::linger, 0);
+
+    std::random_device rd;
+    std::mt19937_64 random_engine(rd());
+    dealer.set(zmq::sockopt::routing_id,
+               std::string(kBinaryPeerIdentityPrefix) + FormatCorrelationId(random_engine()));
+
+    dealer.connect(ToEndpoint(address_));
+
+    dealer_channel_ = reactor_.Register(
+        std::move(dealer),
+        [weak_self = weak_from_this()](zmq::socket_t& socket) {
+            if (auto self = weak_self.lock()) {
+                self->ReceiveFromDealer(socket);
+            }
+        },
+        [weak_self = weak_from_this()](zmq::socket_t& socket) {
+            if (auto self = weak_self.lock()) {
+                self->FlushOutgoing(socket);
             }
-        }).detach();
+        },
+        [weak_self = weak_from_this()](std::exception_ptr error) {
+            if (auto self = weak_self.lock()) {
+                self->FailDealer(std::move(error));
+            }
+        });
+}
+
+void AbstractMessageBox::FailDealer(std::exception_ptr error) {
+    // The reactor has closed the dealer: nothing queued will be sent, and
+    // neither will anything queued later.
+    outgoing_messages_.close();
+    for (auto& pending_answer : pending_answers_.TakeAll()) {
+        asks_failed_.fetch_add(1, std::memory_order_relaxed);
+        recorder_->Record(pending_answer.trace_id, TraceStage::Failed);
+        timers_.Cancel(pending_answer.timeout_timer);
+        pending_answer.Reject(error);
     }
+}
 
-    return future;
+void AbstractMessageBox::ThrowIfNotQueued(PushResult result) const {
+    if (result == PushResult::Rejected) {
+        throw std::runtime_error("Outgoing queue of " + name_ + " is full");
+    }
+    if (result == PushResult::Closed) {
+        throw std::runtime_error("Dealer of " + name_ + " has failed");
+    }
+}
+
+PushResult AbstractMessageBox::EnqueueOutgoing(OutgoingMessage& message) {
+    std::call_once(dealer_opened_, [this] { OpenDealer(); });
+
+    QueuedMessage queued{.message = std::move(message), .enqueued_at = std::chrono::steady_clock::now()};
+    const auto result = outgoing_messages_.push(queued);
+    if (result == PushResult::Pushed) {
+        outgoing_depth_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Don't leave the asker of an evicted question waiting for its timeout.
+    if (result == PushResult::DroppedOldest) {
+        if (const auto* question = std::get_if<QuestionMessage>(&queued.message)) {
+            FailPendingAnswer(question->correlation_id,
+                              std::make_exception_ptr(std::runtime_error("Question dropped from the outgoing queue")));
+        }
+    }
+    return result;
 }
 
-void AbstractMessageBox::DealerLoop(std::stop_token stop_token) {
-    while (!stop_token.stop_requested()) {
-        zmq::pollitem_t items[] = {{dealer_, 0, ZMQ_POLLIN, 0}};
-        zmq::poll(items, 1, std::chrono::milliseconds{10});
+void AbstractMessageBox::FlushOutgoing(zmq::socket_t& dealer) {
+    // Nothing more is taken off the queue while the dealer is full. The queue
+    // is left unarmed, so pushes in the meantime cost no wakeups; the dealer
+    // becoming writable calls back here.
+    if (!waiting_streams_.empty() && std::chrono::steady_clock::now() >= *hello_deadline_) {
+        text_peer_ = true;
+        ReleaseWaitingStreams();
+    }
+    if (!SendFrames(dealer)) {
+        return;
+    }
+    outgoing_messages_.rearm();
+
+    QueuedMessage queued;
+    while (outgoing_messages_.try_pop(queued)) {
+        outgoing_depth_.fetch_sub(1, std::memory_order_relaxed);
+        enqueue_to_send_.Record(std::chrono::steady_clock::now() - queued.enqueued_at);
+
+        auto& outgoing = queued.message;
+        auto& sent = std::holds_alternative<QuestionMessage>(outgoing) ? questions_sent_
+                     : std::holds_alternative<StreamMessage>(outgoing) ? streams_sent_
+                                                                       : tells_sent_;
+        sent.fetch_add(1, std::memory_order_relaxed);
+
+        const auto* tell = std::get_if<TellMessage>(&outgoing);
+        if (!tell || !BatchTell(*tell)) {
+            // Keeps the batched Tells ahead of whatever was queued after them.
+            SendBatch();
+            std::visit([this](auto&& message) { SendMessage(message); }, outgoing);
+        }
+        if (!SendFrames(dealer)) {
+            return;
+        }
+    }
+
+    if (batch_count_ != 0) {
+        if (tell_batching_.max_delay.count() == 0 || std::chrono::steady_clock::now() >= batch_deadline_) {
+            SendBatch();
+            if (!SendFrames(dealer)) {
+                return;
+            }
+        } else {
+            reactor_.ScheduleAt(*dealer_channel_, batch_deadline_);
+        }
+    }
+
+    PumpStreams(dealer);
+}
 
-        if (items[0].revents & ZMQ_POLLIN) {
-            zmq::message_t message_type_frame;
-            zmq::message_t message_box_name_frame;
-            zmq::message_t correlation_frame;
-            zmq::message_t content_type_frame;
-            zmq::message_t content_frame;
+bool AbstractMessageBox::SendFrames(zmq::socket_t& dealer) {
+    if (frames_.Send(dealer)) {
+        return true;
+    }
+    reactor_.WaitWritable(*dealer_channel_);
+    return false;
+}
 
-            EnsureRecv(dealer_, message_type_frame, "answer message type");
-            EnsureRecv(dealer_, message_box_name_frame, "answer message box name");
-            EnsureRecv(dealer_, correlation_frame, "answer correlation id");
-            EnsureRecv(dealer_, content_type_frame, "answer content type");
-            EnsureRecv(dealer_, content_frame, "answer content");
+void AbstractMessageBox::PumpStreams(zmq::socket_t& dealer) {
+    // A full dealer pumps again once it is writable.
+    if (!frames_.empty()) {
+        return;
+    }
 
-            const std::string message_type_string = FrameToString(message_type_frame);
-            const std::string correlation_id = FrameToString(correlation_frame);
-            const std::string content_type = FrameToString(content_type_frame);
-            const std::string content = FrameToString(content_frame, false);
+    // One chunk per stream per pass; messages queued in the meantime go out
+    // before the next pass.
+    bool more = false;
+    for (auto it = streams_.begin(); it != streams_.end();) {
+        auto& stream = *it;
+        if (stream.credits == 0) {
+            ++it;
+            continue;
+        }
 
-            MessageType message_type;
+        const auto chunk = std::move(stream.next);
+        bool last = chunk.empty();
+        if (!last) {
             try {
-                message_type = message_type_from_string(message_type_string);
+                stream.next = stream.source();
             } catch (...) {
+                // The receiver is told the stream ended early, one chunk past
+                // the window at most.
+                ReportError(on_error_, std::current_exception());
+                SendChunk(stream, chunk, false);
+                SendChunk(stream, Payload{}, true, true);
+                it = streams_.erase(it);
+                if (!SendFrames(dealer)) {
+                    return;
+                }
                 continue;
             }
-
-            if (message_type == MessageType::Answer) {
-                ReceiveAnswer(AnswerMessage{.message_box_name = name_,
-                                            .correlation_id = correlation_id,
-                                            .content_type = content_type,
-                                            .content = content});
-            }
+            last = stream.next.empty();
         }
 
-        OutgoingMessage outgoing;
-        while (outgoing_messages_.try_pop(outgoing)) {
-            std::visit([this](auto&& message) { SendMessage(message); }, outgoing);
+        SendChunk(stream, chunk, last);
+        if (last) {
+            it = streams_.erase(it);
+        } else {
+            --stream.credits;
+            more = more || stream.credits > 0;
+            ++it;
         }
+        if (!SendFrames(dealer)) {
+            return;
+        }
+    }
+
+    if (more) {
+        reactor_.ScheduleAt(*dealer_channel_, std::chrono::steady_clock::now());
+    }
+}
+
+void AbstractMessageBox::SendChunk(const OutgoingStream& stream, const Payload& chunk, bool last, bool aborted) {
+    std::uint16_t flags = 0;
+    const auto content = Compress(stream.content_type, chunk, flags);
+    flags |= kWireFlagChunk;
+    if (last) {
+        flags |= kWireFlagLastChunk;
+    }
+    if (aborted) {
+        flags |= kWireFlagRejected;
+    }
+
+    const auto header =
+        EncodeWireHeader(WireHeader{.type = MessageType::Tell, .flags = flags, .correlation_id = stream.id});
+    chunks_sent_.fetch_add(1, std::memory_order_relaxed);
+    frames_.Add(zmq::buffer(header), true);
+    frames_.Add(zmq::buffer(name_), true);
+    frames_.Add(zmq::buffer(stream.content_type.name()), true);
+    frames_.Add(content, false);
+}
+
+void AbstractMessageBox::ReceiveCredit(zmq::socket_t& dealer, CorrelationId stream_id) {
+    const auto it = std::find_if(
+        streams_.begin(), streams_.end(), [stream_id](const OutgoingStream& stream) { return stream.id == stream_id; });
+    if (it != streams_.end() && it->credits++ == 0) {
+        PumpStreams(dealer);
+    }
+}
+
+bool AbstractMessageBox::BatchTell(const TellMessage& message) {
+    const auto content_type = message.content_type.name();
+    const auto record_size = kBatchRecordOverhead + content_type.size() + message.content.size();
+    if (tell_batching_.max_messages == 0 || wire_format_ != WireFormat::Binary ||
+        record_size >= tell_batching_.max_bytes ||
+        compressor_.Compresses(message.content_type, message.content.size())) {
+        return false;
+    }
+
+    if (batch_records_.size() + record_size > tell_batching_.max_bytes) {
+        SendBatch();
+    }
+    if (batch_count_ == 0) {
+        batch_deadline_ = std::chrono::steady_clock::now() + tell_batching_.max_delay;
+    }
+
+    AppendBatchRecord(batch_records_, content_type, message.content.view());
+    if (++batch_count_ >= tell_batching_.max_messages) {
+        SendBatch();
+    }
+    return true;
+}
+
+void AbstractMessageBox::SendBatch() {
+    if (batch_count_ == 0) {
+        return;
+    }
+
+    const auto header = EncodeWireHeader(WireHeader{.type = MessageType::Tell, .flags = kWireFlagBatch});
+    frames_.Add(zmq::buffer(header), true);
+    frames_.Add(zmq::buffer(name_), true);
+    frames_.Add(zmq::buffer(batch_records_), false);
+
+    batch_records_.clear();
+    batch_count_ = 0;
+}
+
+void AbstractMessageBox::ReceiveFromDealer(zmq::socket_t& dealer) {
+    std::array<zmq::message_t, 5> frames;
+    const auto frame_count = RecvMultipart(dealer, frames, "answer");
 
-        if (stop_token.stop_requested()) {
-            break;
+    if (const auto header = DecodeWireHeader(frames[0].data(), frames[0].size())) {
+        if (header->type == MessageType::Hello) {
+            wire_format_ = WireFormat::Binary;
+            if (!waiting_streams_.empty()) {
+                ReleaseWaitingStreams();
+                FlushOutgoing(dealer);
+            }
+        } else if (header->type == MessageType::Answer && (header->flags & kWireFlagChunk) != 0) {
+            ReceiveCredit(dealer, header->correlation_id);
+        } else if (header->type == MessageType::Answer && frame_count == 4) {
+            AnswerMessage answer{.message_box_name = name_,
+                                 .correlation_id = header->correlation_id,
+                                 .content_type = FrameToString(frames[2]),
+                                 .content = FrameToString(frames[3], false),
+                                 .rejected = (header->flags & kWireFlagRejected) != 0};
+            if ((header->flags & kWireCompressionFlags) != 0) {
+                // A type this process never named has no codec, and so no dictionary.
+                const auto content_type = ContentType::Find(answer.content_type).value_or(ContentType{});
+                std::string content;
+                if (!compressor_.Decompress(content_type, header->flags, answer.content, content)) {
+                    FailPendingAnswer(answer.correlation_id,
+                                      std::make_exception_ptr(std::runtime_error("Answer failed to decompress")));
+                    return;
+                }
+                answer.content = std::move(content);
+            }
+            ReceiveAnswer(std::move(answer));
         }
+        return;
+    }
 
-        if (outgoing_messages_.wait_pop(outgoing, std::chrono::milliseconds{10})) {
-            std::visit([this](auto&& message) { SendMessage(message); }, outgoing);
+    if (frame_count != 5) {
+        return;
+    }
+
+    MessageType message_type;
+    try {
+        message_type = message_type_from_string(FrameToString(frames[0]));
+    } catch (...) {
+        return;
+    }
+
+    // Text routers echo the correlation id we sent, which is always native.
+    const auto correlation_id = ParseCorrelationId(FrameToString(frames[2]));
+    // A native router greets before it answers, so this peer is a text one.
+    if (message_type == MessageType::Answer && wire_format_ != WireFormat::Binary && !text_peer_) {
+        text_peer_ = true;
+        if (!waiting_streams_.empty()) {
+            ReleaseWaitingStreams();
+            FlushOutgoing(dealer);
         }
     }
+    if (message_type == MessageType::Answer && correlation_id) {
+        ReceiveAnswer(AnswerMessage{.message_box_name = name_,
+                                    .correlation_id = *correlation_id,
+                                    .content_type = FrameToString(frames[3]),
+                                    .content = FrameToString(frames[4], false)});
+    }
 }
 
 void AbstractMessageBox::SendMessage(const TellMessage& message) {
-    EnsureSend(dealer_, zmq::buffer(std::string(to_string(MessageType::Tell))), zmq::send_flags::sndmore, "tell type");
-    EnsureSend(dealer_, zmq::buffer(message.message_box_name), zmq::send_flags::sndmore, "tell envelope");
-    EnsureSend(dealer_, zmq::buffer(std::string{}), zmq::send_flags::sndmore, "tell delimiter");
-    EnsureSend(dealer_, zmq::buffer(message.content_type), zmq::send_flags::sndmore, "tell content type");
-    EnsureSend(dealer_, zmq::buffer(message.content), zmq::send_flags::none, "tell content");
+    if (wire_format_ == WireFormat::Binary) {
+        std::uint16_t flags = 0;
+        const auto content = Compress(message.content_type, message.content, flags);
+        const auto header = EncodeWireHeader(WireHeader{.type = MessageType::Tell, .flags = flags});
+        frames_.Add(zmq::buffer(header), true);
+        frames_.Add(zmq::buffer(message.message_box_name), true);
+        frames_.Add(zmq::buffer(message.content_type.name()), true);
+        frames_.Add(content, false);
+        return;
+    }
+
+    frames_.Add(zmq::buffer(to_string(MessageType::Tell)), true);
+    frames_.Add(zmq::buffer(message.message_box_name), true);
+    frames_.Add(zmq::const_buffer{}, true);
+    frames_.Add(zmq::buffer(message.content_type.name()), true);
+    frames_.Add(message.content, false);
+    ExpectHello();
 }
 
 void AbstractMessageBox::SendMessage(const QuestionMessage& message) {
-    EnsureSend(dealer_,
-               zmq::buffer(std::string(to_string(MessageType::Question))),
-               zmq::send_flags::sndmore,
-               "question type");
-    EnsureSend(dealer_, zmq::buffer(message.message_box_name), zmq::send_flags::sndmore, "question envelope");
-    EnsureSend(dealer_, zmq::buffer(message.correlation_id), zmq::send_flags::sndmore, "question correlation");
-    EnsureSend(dealer_, zmq::buffer(message.content_type), zmq::send_flags::sndmore, "question content type");
-    EnsureSend(dealer_, zmq::buffer(message.content), zmq::send_flags::none, "question content");
-}
-
-void AbstractMessageBox::SendAnswer(const PendingQuestion& pending_question, const Answer& answer) {
-    AnswerMessage answer_message{.message_box_name = name_,
-                                 .correlation_id = pending_question.question_message.correlation_id,
-                                 .content_type = answer.content_type,
-                                 .content = answer.content};
-
-    pending_question.answer_queue->push(IdentityMessage<AnswerMessage>{
-        .dealer_identity = pending_question.dealer_identity,
-        .message = std::move(answer_message)});
-}
-
-std::string AbstractMessageBox::GenerateCorrelationId() {
-    std::uniform_int_distribution<std::uint64_t> distribution;
-    std::lock_guard lock(random_mutex_);
-    auto value = distribution(random_engine_);
-    constexpr char digits[] = "0123456789abcdef";
-    std::string result(16, '0');
-    for (int i = 15; i >= 0; --i) {
-        result[i] = digits[value & 0xF];
-        value >>= 4;
+    if (wire_format_ == WireFormat::Binary) {
+        std::uint16_t flags = 0;
+        const auto content = Compress(message.content_type, message.content, flags);
+        const bool traced = message.trace_id != 0;
+        if (traced) {
+            flags |= kWireFlagTraced;
+        }
+        const auto header = EncodeWireHeader(
+            WireHeader{.type = MessageType::Question, .flags = flags, .correlation_id = message.correlation_id});
+        frames_.Add(zmq::buffer(header), true);
+        frames_.Add(zmq::buffer(message.message_box_name), true);
+        frames_.Add(zmq::buffer(message.content_type.name()), true);
+        frames_.Add(content, traced);
+        if (traced) {
+            frames_.Add(zmq::buffer(EncodeTraceFrame(message.trace_id)), false);
+            recorder_->Record(message.trace_id, TraceStage::Sent);
+        }
+        return;
     }
-    return result;
+
+    const auto correlation_id = FormatCorrelationId(message.correlation_id);
+    frames_.Add(zmq::buffer(to_string(MessageType::Question)), true);
+    frames_.Add(zmq::buffer(message.message_box_name), true);
+    frames_.Add(zmq::buffer(correlation_id), true);
+    frames_.Add(zmq::buffer(message.content_type.name()), true);
+    frames_.Add(message.content, false);
+    ExpectHello();
+    // Text peers cannot carry the trace; only the asker's stages are recorded.
+    recorder_->Record(message.trace_id, TraceStage::Sent);
 }
 
-void AbstractMessageBox::FulfillPendingAnswer(const std::string& correlation_id, const Answer& answer) {
-    std::shared_ptr<std::promise<Answer>> promise;
-    {
-        std::lock_guard lock(pending_answers_mutex_);
-        auto it = pending_answers_.find(correlation_id);
-        if (it == pending_answers_.end()) {
-            return;
-        }
-        promise = it->second;
-        pending_answers_.erase(it);
+void AbstractMessageBox::ExpectHello() {
+    // Native routers greet a dealer on its first message.
+    if (!hello_deadline_ && !text_peer_) {
+        hello_deadline_ = std::chrono::steady_clock::now() + streams_options_.hello_timeout;
     }
-    promise->set_value(answer);
 }
 
-void AbstractMessageBox::FailPendingAnswer(const std::string& correlation_id, std::exception_ptr error) {
-    std::shared_ptr<std::promise<Answer>> promise;
-    {
-        std::lock_guard lock(pending_answers_mutex_);
-        auto it = pending_answers_.find(correlation_id);
-        if (it == pending_answers_.end()) {
-            return;
+Payload AbstractMessageBox::Compress(ContentType content_type, const Payload& content, std::uint16_t& flags) const {
+    std::string compressed;
+    flags = compressor_.Compress(content_type, content.view(), compressed);
+    return flags != 0 ? Payload(std::move(compressed)) : content;
+}
+
+void AbstractMessageBox::SendMessage(StreamMessage& message) {
+    // Nothing is sent just to learn the router's wire format: every probe
+    // reaches a box on C# routers. A stream waits only for the Hello that an
+    // earlier message earned; a stream sent before anything else goes whole.
+    if (wire_format_ != WireFormat::Binary && !text_peer_ && hello_deadline_) {
+        reactor_.ScheduleAt(*dealer_channel_, *hello_deadline_);
+        waiting_streams_.push_back(std::move(message));
+        return;
+    }
+
+    Payload first;
+    try {
+        first = message.source();
+    } catch (...) {
+        // Nothing of the stream was sent, so the receiver never sees it.
+        ReportError(on_error_, std::current_exception());
+        return;
+    }
+
+    if (wire_format_ == WireFormat::Binary) {
+        streams_.push_back(OutgoingStream{.id = NextStreamId(),
+                                          .content_type = message.content_type,
+                                          .source = std::move(message.source),
+                                          .next = std::move(first),
+                                          .credits = streams_options_.window});
+        return;
+    }
+
+    // Text peers cannot stream; they get the whole content as one Tell. Its
+    // correlation id, which text routers ignore on Tells, is a stream id, so
+    // a native router hands it to ListenStream() handlers as one last chunk.
+    std::string content;
+    try {
+        for (auto chunk = std::move(first); !chunk.empty(); chunk = message.source()) {
+            content.append(chunk.view());
         }
-        promise = it->second;
-        pending_answers_.erase(it);
+    } catch (...) {
+        ReportError(on_error_, std::current_exception());
+        return;
+    }
+    const auto stream_id = FormatCorrelationId(NextStreamId());
+    chunks_sent_.fetch_add(1, std::memory_order_relaxed);
+    frames_.Add(zmq::buffer(to_string(MessageType::Tell)), true);
+    frames_.Add(zmq::buffer(message.message_box_name), true);
+    frames_.Add(zmq::buffer(stream_id), true);
+    frames_.Add(zmq::buffer(message.content_type.name()), true);
+    frames_.Add(Payload(std::move(content)), false);
+    ExpectHello();
+}
+
+void AbstractMessageBox::ReleaseWaitingStreams() {
+    auto waiting = std::move(waiting_streams_);
+    waiting_streams_.clear();
+    for (auto& message : waiting) {
+        SendMessage(message);
+    }
+}
+
+void AbstractMessageBox::FulfillPendingAnswer(CorrelationId correlation_id, Answer answer) {
+    auto pending_answer = pending_answers_.Take(correlation_id);
+    if (!pending_answer) {
+        return;
+    }
+    timers_.Cancel(pending_answer->timeout_timer);
+    answers_received_.fetch_add(1, std::memory_order_relaxed);
+    ask_rtt_.Record(std::chrono::steady_clock::now() - pending_answer->asked_at);
+    recorder_->Record(pending_answer->trace_id, TraceStage::Answered);
+    pending_answer->Resolve(std::move(answer));
+}
+
+void AbstractMessageBox::FailPendingAnswer(CorrelationId correlation_id, std::exception_ptr error, bool timed_out) {
+    auto pending_answer = pending_answers_.Take(correlation_id);
+    if (!pending_answer) {
+        return;
+    }
+    (timed_out ? asks_timed_out_ : asks_failed_).fetch_add(1, std::memory_order_relaxed);
+    recorder_->Record(pending_answer->trace_id, TraceStage::Failed);
+    timers_.Cancel(pending_answer->timeout_timer);
+    pending_answer->Reject(std::move(error));
+}
+
+void AbstractMessageBox::PendingAnswer::Resolve(Answer answer) {
+    if (awaiter) {
+        awaiter->Resolve(std::move(answer));
+    } else {
+        promise->set_value(std::move(answer));
+    }
+}
+
+void AbstractMessageBox::PendingAnswer::Reject(std::exception_ptr error) {
+    if (awaiter) {
+        awaiter->Reject(std::move(error));
+    } else {
+        promise->set_exception(std::move(error));
     }
-    promise->set_exception(error);
 }
 
 } // namespace minx::zmesh
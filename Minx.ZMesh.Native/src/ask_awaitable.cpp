@@ -0,0 +1,93 @@
+#include "minx/zmesh/ask_awaitable.hpp"
+
+#include <utility>
+
+#include "minx/zmesh/abstract_message_box.hpp"
+
+namespace minx::zmesh {
+
+AskAwaitable::AskAwaitable(std::shared_ptr<AbstractMessageBox> message_box,
+                           ContentType content_type,
+                           Payload content,
+                           AskOptions options)
+    : message_box_(std::move(message_box)),
+      content_type_(content_type),
+      content_(std::move(content)),
+      options_(options) {}
+
+AskAwaitable::~AskAwaitable() {
+    // Still pending: the coroutine was destroyed while suspended. The answer or
+    // timeout may already be completing the state, but it no longer resumes.
+    if (!state_ || !state_->Cancel()) {
+        return;
+    }
+    if (const auto correlation_id = state_->correlation_id.load(std::memory_order_acquire); correlation_id != 0) {
+        if (auto message_box = asked_box_.lock()) {
+            message_box->CancelAsk(correlation_id);
+        }
+    }
+}
+
+void AskAwaitable::await_suspend(std::coroutine_handle<> handle) {
+    state_ = std::make_shared<State>(handle, options_.resume_on);
+
+    // The answer may resume the coroutine, and destroy this awaiter, before
+    // StartAsk returns; only locals may be touched afterwards.
+    auto message_box = std::move(message_box_);
+    asked_box_ = message_box;
+    message_box->StartAsk(*this);
+}
+
+Answer AskAwaitable::await_resume() {
+    if (state_->error) {
+        std::rethrow_exception(state_->error);
+    }
+    return std::move(*state_->answer);
+}
+
+void AskAwaitable::State::Resolve(Answer answer) {
+    Complete([this, &answer] { this->answer = std::move(answer); });
+}
+
+void AskAwaitable::State::Reject(std::exception_ptr error) {
+    Complete([this, &error] { this->error = std::move(error); });
+}
+
+bool AskAwaitable::State::Cancel() noexcept {
+    auto status = status_.load(std::memory_order_acquire);
+    while (status != Status::Resumed && status != Status::Cancelled) {
+        if (status_.compare_exchange_weak(status, Status::Cancelled, std::memory_order_acq_rel)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename Write>
+void AskAwaitable::State::Complete(Write&& write) {
+    auto expected = Status::Pending;
+    if (!status_.compare_exchange_strong(expected, Status::Completing, std::memory_order_acq_rel)) {
+        return;
+    }
+    write();
+    expected = Status::Completing;
+    if (!status_.compare_exchange_strong(expected, Status::Ready, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    if (resume_on_ != nullptr) {
+        resume_on_->Post([self = shared_from_this()] { self->Resume(); });
+    } else {
+        Resume();
+    }
+}
+
+void AskAwaitable::State::Resume() {
+    // Cancelled while the resumption was queued: the frame is gone.
+    auto expected = Status::Ready;
+    if (status_.compare_exchange_strong(expected, Status::Resumed, std::memory_order_acq_rel)) {
+        handle_.resume();
+    }
+}
+
+} // namespace minx::zmesh
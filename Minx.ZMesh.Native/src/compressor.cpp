@@ -0,0 +1,194 @@
+#include "minx/zmesh/compressor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+#include <lz4.h>
+#include <zstd.h>
+
+#include "minx/zmesh/wire_format.hpp"
+
+namespace minx::zmesh {
+
+namespace {
+
+constexpr std::size_t kSizePrefix = 4;
+
+// Refuses frames claiming more than this, so a corrupt or hostile size prefix
+// cannot make the receiver allocate without bound.
+constexpr std::size_t kMaxDecompressedSize = std::size_t{1} << 30;
+
+struct ZstdContexts {
+    ZstdContexts()
+        : compress(ZSTD_createCCtx()),
+          decompress(ZSTD_createDCtx()) {}
+
+    ~ZstdContexts() {
+        ZSTD_freeCCtx(compress);
+        ZSTD_freeDCtx(decompress);
+    }
+
+    ZstdContexts(const ZstdContexts&) = delete;
+    ZstdContexts& operator=(const ZstdContexts&) = delete;
+
+    ZSTD_CCtx* compress;
+    ZSTD_DCtx* decompress;
+};
+
+ZstdContexts& ThreadZstdContexts() {
+    thread_local ZstdContexts contexts;
+    return contexts;
+}
+
+void WriteSizePrefix(std::string& out, std::size_t size) {
+    for (std::size_t i = 0; i < kSizePrefix; ++i) {
+        out[i] = static_cast<char>(size >> (8 * i));
+    }
+}
+
+std::size_t ReadSizePrefix(std::string_view frame) {
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < kSizePrefix; ++i) {
+        size |= static_cast<std::size_t>(static_cast<std::uint8_t>(frame[i])) << (8 * i);
+    }
+    return size;
+}
+
+} // namespace
+
+struct Compressor::Codec {
+    explicit Codec(const CompressionOptions& codec_options)
+        : options(codec_options) {
+        if (options.algorithm == CompressionAlgorithm::Zstd && options.dictionary) {
+            const auto& dictionary = *options.dictionary;
+            compress_dictionary = ZSTD_createCDict(dictionary.data(), dictionary.size(), Level());
+            decompress_dictionary = ZSTD_createDDict(dictionary.data(), dictionary.size());
+        }
+    }
+
+    ~Codec() {
+        ZSTD_freeCDict(compress_dictionary);
+        ZSTD_freeDDict(decompress_dictionary);
+    }
+
+    int Level() const noexcept {
+        return options.level != 0 ? options.level : ZSTD_CLEVEL_DEFAULT;
+    }
+
+    CompressionOptions options;
+    ZSTD_CDict* compress_dictionary{nullptr};
+    ZSTD_DDict* decompress_dictionary{nullptr};
+};
+
+Compressor::Compressor(const std::unordered_map<std::string, CompressionOptions>& options) {
+    for (const auto& [name, codec_options] : options) {
+        if (codec_options.algorithm != CompressionAlgorithm::None) {
+            codecs_.GetOrCreate(ContentType(name).id(), codec_options);
+        }
+    }
+}
+
+Compressor::~Compressor() = default;
+
+bool Compressor::Compresses(ContentType content_type, std::size_t size) const noexcept {
+    const auto* codec = codecs_.Find(content_type.id());
+    return codec != nullptr && size >= codec->options.min_size &&
+           size <= std::numeric_limits<std::uint32_t>::max();
+}
+
+std::uint16_t Compressor::Compress(ContentType content_type, std::string_view content, std::string& out) const {
+    if (!Compresses(content_type, content.size())) {
+        return 0;
+    }
+    const auto& codec = *codecs_.Find(content_type.id());
+
+    std::size_t compressed_size = 0;
+    std::uint16_t flag = 0;
+    if (codec.options.algorithm == CompressionAlgorithm::Lz4) {
+        if (content.size() > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+            return 0;
+        }
+        const auto source_size = static_cast<int>(content.size());
+        out.resize(kSizePrefix + static_cast<std::size_t>(LZ4_compressBound(source_size)));
+        const auto written = LZ4_compress_fast(content.data(),
+                                               out.data() + kSizePrefix,
+                                               source_size,
+                                               static_cast<int>(out.size() - kSizePrefix),
+                                               codec.options.level > 0 ? codec.options.level : 1);
+        if (written <= 0) {
+            return 0;
+        }
+        compressed_size = static_cast<std::size_t>(written);
+        flag = kWireFlagLz4;
+    } else {
+        auto& contexts = ThreadZstdContexts();
+        out.resize(kSizePrefix + ZSTD_compressBound(content.size()));
+        const auto written =
+            codec.compress_dictionary
+                ? ZSTD_compress_usingCDict(contexts.compress,
+                                           out.data() + kSizePrefix,
+                                           out.size() - kSizePrefix,
+                                           content.data(),
+                                           content.size(),
+                                           codec.compress_dictionary)
+                : ZSTD_compressCCtx(contexts.compress,
+                                    out.data() + kSizePrefix,
+                                    out.size() - kSizePrefix,
+                                    content.data(),
+                                    content.size(),
+                                    codec.Level());
+        if (ZSTD_isError(written)) {
+            return 0;
+        }
+        compressed_size = written;
+        flag = kWireFlagZstd;
+    }
+
+    // Not worth the receiver's time if it did not shrink.
+    if (kSizePrefix + compressed_size >= content.size()) {
+        return 0;
+    }
+    out.resize(kSizePrefix + compressed_size);
+    WriteSizePrefix(out, content.size());
+    return flag;
+}
+
+bool Compressor::Decompress(ContentType content_type,
+                            std::uint16_t flags,
+                            std::string_view frame,
+                            std::string& out) const {
+    if (frame.size() < kSizePrefix) {
+        return false;
+    }
+    const auto size = ReadSizePrefix(frame);
+    if (size > kMaxDecompressedSize) {
+        return false;
+    }
+    frame.remove_prefix(kSizePrefix);
+    out.resize(size);
+
+    if ((flags & kWireCompressionFlags) == kWireFlagLz4) {
+        const auto read =
+            LZ4_decompress_safe(frame.data(), out.data(), static_cast<int>(frame.size()), static_cast<int>(size));
+        return read >= 0 && static_cast<std::size_t>(read) == size;
+    }
+    if ((flags & kWireCompressionFlags) != kWireFlagZstd) {
+        return false;
+    }
+
+    auto& contexts = ThreadZstdContexts();
+    const auto* codec = codecs_.Find(content_type.id());
+    const auto read = codec != nullptr && codec->decompress_dictionary
+                          ? ZSTD_decompress_usingDDict(contexts.decompress,
+                                                       out.data(),
+                                                       out.size(),
+                                                       frame.data(),
+                                                       frame.size(),
+                                                       codec->decompress_dictionary)
+                          : ZSTD_decompressDCtx(contexts.decompress, out.data(), out.size(), frame.data(), frame.size());
+    return !ZSTD_isError(read) && read == size;
+}
+
+} // namespace minx::zmesh
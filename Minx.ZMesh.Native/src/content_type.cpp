@@ -0,0 +1,139 @@
+#include "minx/zmesh/content_type.hpp"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace minx::zmesh {
+
+// Open-addressed table of interned names. Readers probe the published table
+// without locking; writers insert under a mutex and, when the table fills up,
+// publish a larger copy. Entries are never removed and superseded tables are
+// kept until exit, so a reader can never see freed memory.
+class ContentTypeRegistry {
+public:
+    using Entry = ContentType::Entry;
+
+    static ContentTypeRegistry& Instance() {
+        static ContentTypeRegistry registry;
+        return registry;
+    }
+
+    // A name from a peer is not interned, and null is returned, once
+    // kMaxPeerContentTypes names have been counted in peer_names. The count
+    // only changes under the mutex.
+    const Entry* Intern(std::string_view name, std::atomic<std::size_t>* peer_names = nullptr) {
+        const auto hash = std::hash<std::string_view>{}(name);
+        if (const auto* entry = Find(*table_.load(std::memory_order_acquire), name, hash)) {
+            return entry;
+        }
+
+        std::lock_guard lock(mutex_);
+        auto* table = table_.load(std::memory_order_relaxed);
+        if (const auto* entry = Find(*table, name, hash)) {
+            return entry;
+        }
+        if (peer_names != nullptr) {
+            if (peer_names->load(std::memory_order_relaxed) >= ContentType::kMaxPeerContentTypes) {
+                return nullptr;
+            }
+            peer_names->fetch_add(1, std::memory_order_relaxed);
+        }
+
+        const auto& entry = entries_.emplace_back(
+            Entry{.name = std::string(name), .id = static_cast<ContentTypeId>(entries_.size()), .hash = hash});
+        if (entries_.size() * 2 > table->mask + 1) {
+            table = Grow(*table);
+        }
+        Insert(*table, &entry);
+        return &entry;
+    }
+
+    const Entry* Lookup(std::string_view name) const noexcept {
+        return Find(*table_.load(std::memory_order_acquire), name, std::hash<std::string_view>{}(name));
+    }
+
+    const Entry* Empty() const noexcept {
+        return empty_;
+    }
+
+private:
+    struct Table {
+        std::size_t mask;
+        std::unique_ptr<std::atomic<const Entry*>[]> slots;
+    };
+
+    ContentTypeRegistry() {
+        auto table = std::make_unique<Table>(Table{.mask = 63, .slots = std::make_unique<std::atomic<const Entry*>[]>(64)});
+        table_.store(table.get(), std::memory_order_release);
+        tables_.push_back(std::move(table));
+        empty_ = Intern({});
+    }
+
+    static const Entry* Find(const Table& table, std::string_view name, std::size_t hash) noexcept {
+        for (auto index = hash & table.mask;; index = (index + 1) & table.mask) {
+            const auto* entry = table.slots[index].load(std::memory_order_acquire);
+            if (entry == nullptr) {
+                return nullptr;
+            }
+            if (entry->hash == hash && entry->name == name) {
+                return entry;
+            }
+        }
+    }
+
+    static void Insert(Table& table, const Entry* entry) noexcept {
+        auto index = entry->hash & table.mask;
+        while (table.slots[index].load(std::memory_order_relaxed) != nullptr) {
+            index = (index + 1) & table.mask;
+        }
+        table.slots[index].store(entry, std::memory_order_release);
+    }
+
+    Table* Grow(const Table& table) {
+        const auto capacity = (table.mask + 1) * 2;
+        auto grown = std::make_unique<Table>(
+            Table{.mask = capacity - 1, .slots = std::make_unique<std::atomic<const Entry*>[]>(capacity)});
+        for (std::size_t index = 0; index <= table.mask; ++index) {
+            if (const auto* entry = table.slots[index].load(std::memory_order_relaxed)) {
+                Insert(*grown, entry);
+            }
+        }
+
+        auto* published = grown.get();
+        tables_.push_back(std::move(grown));
+        table_.store(published, std::memory_order_release);
+        return published;
+    }
+
+    std::atomic<Table*> table_{nullptr};
+    std::mutex mutex_;
+    std::deque<Entry> entries_;
+    std::vector<std::unique_ptr<Table>> tables_;
+    const Entry* empty_{nullptr};
+};
+
+ContentType::ContentType() noexcept
+    : entry_(ContentTypeRegistry::Instance().Empty()) {}
+
+ContentType::ContentType(std::string_view name)
+    : entry_(ContentTypeRegistry::Instance().Intern(name)) {}
+
+std::optional<ContentType> ContentType::Find(std::string_view name) noexcept {
+    if (const auto* entry = ContentTypeRegistry::Instance().Lookup(name)) {
+        return ContentType(entry);
+    }
+    return std::nullopt;
+}
+
+std::optional<ContentType> ContentType::FromPeer(std::string_view name, std::atomic<std::size_t>& interned) {
+    if (const auto* entry = ContentTypeRegistry::Instance().Intern(name, &interned)) {
+        return ContentType(entry);
+    }
+    return std::nullopt;
+}
+
+} // namespace minx::zmesh
@@ -0,0 +1,27 @@
+#include "minx/zmesh/error_handler.hpp"
+
+#include <cstdio>
+#include <exception>
+
+namespace minx::zmesh {
+
+void ReportError(const ErrorHandler& on_error, std::exception_ptr error) noexcept {
+    if (on_error) {
+        try {
+            on_error(error);
+            return;
+        } catch (...) {
+            // Fall back to stderr; there is nobody left to report to.
+        }
+    }
+
+    try {
+        std::rethrow_exception(error);
+    } catch (const std::exception& ex) {
+        std::fprintf(stderr, "minx::zmesh: %s\n", ex.what());
+    } catch (...) {
+        std::fprintf(stderr, "minx::zmesh: unknown exception\n");
+    }
+}
+
+} // namespace minx::zmesh
@@ -0,0 +1,76 @@
+#include "minx/zmesh/executor.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace minx::zmesh {
+
+ThreadPoolExecutor::ThreadPoolExecutor(std::size_t thread_count, ErrorHandler on_error)
+    : Executor(std::move(on_error)) {
+    thread_count = std::max<std::size_t>(thread_count, 1);
+    threads_.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back([this](std::stop_token stop_token) { Run(stop_token); });
+    }
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+    Stop();
+}
+
+void ThreadPoolExecutor::Post(Task task) {
+    {
+        std::lock_guard lock(mutex_);
+        if (stopped_) {
+            return;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void ThreadPoolExecutor::Stop() {
+    {
+        std::lock_guard lock(mutex_);
+        if (stopped_) {
+            return;
+        }
+        stopped_ = true;
+    }
+
+    for (auto& thread : threads_) {
+        thread.request_stop();
+    }
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    std::lock_guard lock(mutex_);
+    tasks_.clear();
+}
+
+void ThreadPoolExecutor::Run(std::stop_token stop_token) {
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock lock(mutex_);
+            if (!cv_.wait(lock, stop_token, [this] { return !tasks_.empty(); })) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        // A throwing handler must not take the pool thread down with it.
+        try {
+            task();
+        } catch (...) {
+            ReportError(std::current_exception());
+        }
+    }
+}
+
+} // namespace minx::zmesh
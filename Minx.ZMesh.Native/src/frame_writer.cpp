@@ -0,0 +1,78 @@
+#include "minx/zmesh/frame_writer.hpp"
+
+#include <cerrno>
+#include <memory>
+
+namespace minx::zmesh {
+
+namespace {
+
+// Below this size copying into the frame is cheaper than handing over ownership.
+constexpr std::size_t kZeroCopyThreshold = 4096;
+
+} // namespace
+
+void FrameWriter::Add(const zmq::const_buffer& frame, bool more) {
+    frames_.push_back(Frame{.message = zmq::message_t(frame.data(), frame.size()), .more = more});
+    if (!more) {
+        ++message_count_;
+    }
+}
+
+void FrameWriter::Add(const Payload& payload, bool more) {
+    if (payload.size() < kZeroCopyThreshold || !payload.owner()) {
+        Add(zmq::buffer(payload.view()), more);
+        return;
+    }
+
+    // libzmq releases the bytes from its I/O thread once they are on the wire.
+    auto owner = std::make_unique<std::shared_ptr<const void>>(payload.owner());
+    zmq::message_t message(
+        const_cast<char*>(payload.data()),
+        payload.size(),
+        [](void*, void* hint) { delete static_cast<std::shared_ptr<const void>*>(hint); },
+        owner.get());
+    owner.release();
+    frames_.push_back(Frame{.message = std::move(message), .more = more});
+    if (!more) {
+        ++message_count_;
+    }
+}
+
+bool FrameWriter::Send(zmq::socket_t& socket) {
+    while (!frames_.empty()) {
+        auto& frame = frames_.front();
+        const auto flags = frame.more ? zmq::send_flags::sndmore | zmq::send_flags::dontwait
+                                      : zmq::send_flags::dontwait;
+        try {
+            if (!socket.send(frame.message, flags)) {
+                return false;
+            }
+        } catch (const zmq::error_t& error) {
+            // Other errors reach the reactor, which closes the channel.
+            if (error.num() != EHOSTUNREACH) {
+                throw;
+            }
+            DropMessage();
+            continue;
+        }
+        if (!frame.more) {
+            --message_count_;
+        }
+        frames_.pop_front();
+    }
+    return true;
+}
+
+void FrameWriter::DropMessage() noexcept {
+    while (!frames_.empty()) {
+        const bool more = frames_.front().more;
+        frames_.pop_front();
+        if (!more) {
+            --message_count_;
+            return;
+        }
+    }
+}
+
+} // namespace minx::zmesh
@@ -0,0 +1,443 @@
+#include "minx/zmesh/message_inbox.hpp"
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "minx/zmesh/types.hpp"
+
+namespace minx::zmesh {
+
+namespace {
+
+std::string DescribeException(std::exception_ptr error) {
+    try {
+        std::rethrow_exception(std::move(error));
+    } catch (const std::exception& ex) {
+        return ex.what();
+    } catch (...) {
+        return "Unknown exception";
+    }
+}
+
+// Inbox queues are pushed to without the inbox mutex, since a push that blocks
+// for room would otherwise hold up Listen/Respond. Taking the mutex after the
+// push orders it against their backlog hand-off: either that hand-off comes
+// later and takes the item, or it already ran and the item is handed over here.
+template <typename T, typename Registration, typename Post>
+void HandOverLate(std::mutex& mutex,
+                  const std::atomic<std::shared_ptr<const Registration>>& handler,
+                  BoundedQueue<T>& queue,
+                  Post post) {
+    std::lock_guard lock(mutex);
+    auto registration = handler.load(std::memory_order_acquire);
+    if (!registration) {
+        return;
+    }
+    std::vector<T> late;
+    queue.drain_into(late, late.max_size());
+    for (auto& item : late) {
+        post(registration, std::move(item));
+    }
+}
+
+} // namespace
+
+MessageInbox::MessageInbox(std::string name, Executor& executor, QueueLimit inbox_limit)
+    : name_(std::move(name)),
+      executor_(executor),
+      inbox_limit_(inbox_limit) {}
+
+void MessageInbox::Listen(ContentType content_type, TellViewHandler handler, HandlerOptions options) {
+    auto& inbox = GetInbox(content_type);
+    std::lock_guard lock(inbox.mutex);
+    if (!handler) {
+        inbox.tell_handler.store(nullptr, std::memory_order_release);
+        return;
+    }
+
+    auto registration = std::make_shared<const TellRegistration>(TellRegistration{
+        .handler = std::move(handler),
+        .lane = options.unordered ? nullptr : std::make_shared<SerialLane>(executor_)});
+
+    // Hand over the backlog before publishing the handler, so no newer message
+    // can be posted ahead of it.
+    std::vector<Payload> backlog;
+    inbox.messages.drain_into(backlog, backlog.max_size());
+    for (auto& content : backlog) {
+        PostTell(registration, std::move(content));
+    }
+    inbox.tell_handler.store(std::move(registration), std::memory_order_release);
+}
+
+void MessageInbox::Respond(ContentType question_content_type,
+                           QuestionViewHandler handler,
+                           HandlerOptions options) {
+    auto& inbox = GetInbox(question_content_type);
+    std::lock_guard lock(inbox.mutex);
+    if (!handler) {
+        inbox.question_handler.store(nullptr, std::memory_order_release);
+        return;
+    }
+
+    auto registration = std::make_shared<const QuestionRegistration>(QuestionRegistration{
+        .handler = std::move(handler),
+        .lane = options.unordered ? nullptr : std::make_shared<SerialLane>(executor_)});
+
+    std::vector<PendingQuestion> backlog;
+    inbox.pending_questions.drain_into(backlog, backlog.max_size());
+    for (auto& pending_question : backlog) {
+        PostQuestion(registration, std::move(pending_question));
+    }
+    inbox.question_handler.store(std::move(registration), std::memory_order_release);
+}
+
+void MessageInbox::ListenStream(ContentType content_type, TellStreamHandler handler) {
+    auto& inbox = GetInbox(content_type);
+    std::lock_guard lock(inbox.mutex);
+    if (!handler) {
+        inbox.stream_handler.store(nullptr, std::memory_order_release);
+        return;
+    }
+
+    // Always on a lane: a stream's chunks must be handled in order.
+    auto registration = std::make_shared<const StreamRegistration>(
+        StreamRegistration{.handler = std::move(handler), .lane = std::make_shared<SerialLane>(executor_)});
+
+    std::vector<PendingChunk> backlog;
+    inbox.pending_chunks.drain_into(backlog, backlog.max_size());
+    for (auto& pending_chunk : backlog) {
+        PostChunk(registration, std::move(pending_chunk));
+    }
+    inbox.stream_handler.store(std::move(registration), std::memory_order_release);
+}
+
+bool MessageInbox::TryListen(ContentType content_type, const TellHandler& handler) {
+    return TryListenView(content_type, [&handler](std::string_view content) { handler(std::string(content)); });
+}
+
+bool MessageInbox::TryListenView(ContentType content_type, const TellViewHandler& handler) {
+    Payload message;
+    if (!GetInbox(content_type).messages.try_pop(message)) {
+        return false;
+    }
+    handler(message.view());
+    return true;
+}
+
+std::size_t MessageInbox::TryListenBatch(ContentType content_type,
+                                         std::size_t max_messages,
+                                         const TellBatchHandler& handler) {
+    std::vector<Payload> messages;
+    if (GetInbox(content_type).messages.drain_into(messages, max_messages) == 0) {
+        return 0;
+    }
+
+    std::vector<std::string_view> contents;
+    contents.reserve(messages.size());
+    for (const auto& message : messages) {
+        contents.push_back(message.view());
+    }
+    handler(contents);
+    return messages.size();
+}
+
+bool MessageInbox::TryAnswer(ContentType question_content_type, const QuestionHandler& handler) {
+    return TryAnswerView(question_content_type,
+                         [&handler](std::string_view content) { return handler(std::string(content)); });
+}
+
+bool MessageInbox::TryAnswerView(ContentType question_content_type, const QuestionViewHandler& handler) {
+    PendingQuestion pending_question;
+    if (!GetInbox(question_content_type).pending_questions.try_pop(pending_question)) {
+        return false;
+    }
+
+    pending_question.Trace(TraceStage::HandlerStarted);
+    Answer answer = handler(pending_question.question_message.content.view());
+    pending_question.Trace(TraceStage::HandlerFinished);
+    SendAnswer(pending_question, answer);
+
+    return true;
+}
+
+std::size_t MessageInbox::TryAnswerBatch(ContentType question_content_type,
+                                         std::size_t max_questions,
+                                         const QuestionBatchHandler& handler) {
+    std::vector<PendingQuestion> pending_questions;
+    if (GetInbox(question_content_type).pending_questions.drain_into(pending_questions, max_questions) == 0) {
+        return 0;
+    }
+
+    std::vector<std::string_view> contents;
+    contents.reserve(pending_questions.size());
+    for (const auto& pending_question : pending_questions) {
+        contents.push_back(pending_question.question_message.content.view());
+        pending_question.Trace(TraceStage::HandlerStarted);
+    }
+
+    std::vector<Answer> answers(pending_questions.size());
+    handler(contents, answers);
+
+    for (std::size_t i = 0; i < pending_questions.size(); ++i) {
+        pending_questions[i].Trace(TraceStage::HandlerFinished);
+        SendAnswer(pending_questions[i], answers[i]);
+    }
+    return pending_questions.size();
+}
+
+std::optional<PendingQuestion> MessageInbox::GetQuestion(ContentType question_type) {
+    PendingQuestion pending_question;
+    if (!GetInbox(question_type).pending_questions.try_pop(pending_question)) {
+        return std::nullopt;
+    }
+    return pending_question;
+}
+
+void MessageInbox::ReceiveTell(ContentType content_type, Payload content) {
+    auto& inbox = GetInbox(content_type);
+    inbox.tells_received.fetch_add(1, std::memory_order_relaxed);
+    if (auto registration = inbox.tell_handler.load(std::memory_order_acquire)) {
+        PostTell(std::move(registration), std::move(content));
+        return;
+    }
+    inbox.messages.push(content);
+    HandOverLate(inbox.mutex, inbox.tell_handler, inbox.messages, [this](auto registration, Payload late) {
+        PostTell(std::move(registration), std::move(late));
+    });
+}
+
+void MessageInbox::ReceiveQuestion(PendingQuestion pending_question) {
+    auto& inbox = GetInbox(pending_question.question_message.content_type);
+    inbox.questions_received.fetch_add(1, std::memory_order_relaxed);
+    pending_question.Trace(TraceStage::InboxQueued);
+    if (auto registration = inbox.question_handler.load(std::memory_order_acquire)) {
+        PostQuestion(std::move(registration), std::move(pending_question));
+        return;
+    }
+    // Whichever question is dropped, the new one or the evicted oldest, its
+    // asker is told rather than left to time out.
+    const auto result = inbox.pending_questions.push(pending_question);
+    if (result != PushResult::Pushed) {
+        SendRejection(pending_question, "Inbox of " + name_ + " is full");
+    }
+    HandOverLate(inbox.mutex,
+                 inbox.question_handler,
+                 inbox.pending_questions,
+                 [this](auto registration, PendingQuestion late) {
+                     PostQuestion(std::move(registration), std::move(late));
+                 });
+}
+
+void MessageInbox::ReceiveChunk(PendingChunk pending_chunk) {
+    auto& inbox = GetInbox(pending_chunk.content_type);
+    inbox.chunks_received.fetch_add(1, std::memory_order_relaxed);
+    if (inbox.reset_stream_count.load(std::memory_order_acquire) != 0 && DiscardResetChunk(inbox, pending_chunk)) {
+        return;
+    }
+    if (auto registration = inbox.stream_handler.load(std::memory_order_acquire)) {
+        PostChunk(std::move(registration), std::move(pending_chunk));
+        return;
+    }
+    // Whichever chunk is dropped, the new one or the evicted oldest, its
+    // stream cannot be delivered whole any more.
+    const auto result = inbox.pending_chunks.push(pending_chunk);
+    if (result != PushResult::Pushed) {
+        ResetStream(inbox, pending_chunk);
+    }
+    HandOverLate(inbox.mutex, inbox.stream_handler, inbox.pending_chunks, [this](auto registration, PendingChunk late) {
+        PostChunk(std::move(registration), std::move(late));
+    });
+}
+
+bool MessageInbox::DiscardResetChunk(Inbox& inbox, PendingChunk& pending_chunk) {
+    {
+        std::lock_guard lock(inbox.reset_streams_mutex);
+        if (!inbox.reset_streams.contains(pending_chunk.stream_id)) {
+            return false;
+        }
+        if (pending_chunk.last) {
+            inbox.reset_streams.erase(pending_chunk.stream_id);
+            inbox.reset_stream_count.fetch_sub(1, std::memory_order_release);
+            pending_chunk.content = Payload{};
+            pending_chunk.aborted = true;
+            return false;
+        }
+    }
+    // Keeps the sender's window open so the stream runs to its end.
+    SendCredit(pending_chunk);
+    return true;
+}
+
+void MessageInbox::ResetStream(Inbox& inbox, const PendingChunk& dropped) {
+    SendCredit(dropped);
+    if (dropped.last) {
+        return;
+    }
+    std::lock_guard lock(inbox.reset_streams_mutex);
+    if (inbox.reset_streams.insert(dropped.stream_id).second) {
+        inbox.reset_stream_count.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void MessageInbox::PostHandler(const std::shared_ptr<SerialLane>& lane, Executor::Task task) {
+    if (lane) {
+        lane->Post(std::move(task));
+    } else {
+        executor_.Post(std::move(task));
+    }
+}
+
+void MessageInbox::PostTell(std::shared_ptr<const TellRegistration> registration, Payload content) {
+    const auto& lane = registration->lane;
+    PostHandler(lane, [registration, content = std::move(content)] { registration->handler(content.view()); });
+}
+
+void MessageInbox::PostQuestion(std::shared_ptr<const QuestionRegistration> registration,
+                                PendingQuestion pending_question) {
+    const auto& lane = registration->lane;
+    PostHandler(lane,
+                [self = shared_from_this(), registration, pending_question = std::move(pending_question)] {
+                    pending_question.Trace(TraceStage::HandlerStarted);
+                    Answer answer;
+                    try {
+                        answer = registration->handler(pending_question.question_message.content.view());
+                    } catch (...) {
+                        // The asker gets the error instead of waiting out its
+                        // timeout; the executor reports it here.
+                        self->SendRejection(pending_question, DescribeException(std::current_exception()));
+                        throw;
+                    }
+                    pending_question.Trace(TraceStage::HandlerFinished);
+                    self->SendAnswer(pending_question, answer);
+                });
+}
+
+void MessageInbox::PostChunk(std::shared_ptr<const StreamRegistration> registration, PendingChunk pending_chunk) {
+    const auto& lane = registration->lane;
+    PostHandler(lane, [self = shared_from_this(), registration, pending_chunk = std::move(pending_chunk)] {
+        try {
+            registration->handler(StreamChunk{.stream_id = pending_chunk.stream_id,
+                                              .content = pending_chunk.content.view(),
+                                              .last = pending_chunk.last,
+                                              .aborted = pending_chunk.aborted});
+        } catch (...) {
+            // The window must not shrink for good because one chunk failed.
+            self->SendCredit(pending_chunk);
+            throw;
+        }
+        self->SendCredit(pending_chunk);
+    });
+}
+
+void MessageInbox::SetInboxLimit(QueueLimit limit) {
+    std::lock_guard lock(inbox_limit_mutex_);
+    inbox_limit_ = limit;
+    inboxes_.ForEach([limit](Inbox& inbox) {
+        inbox.messages.set_limit(limit);
+        inbox.pending_questions.set_limit(limit);
+        inbox.pending_chunks.set_limit(limit);
+    });
+}
+
+void MessageInbox::SetInboxLimit(ContentType content_type, QueueLimit limit) {
+    auto& inbox = GetInbox(content_type);
+    inbox.messages.set_limit(limit);
+    inbox.pending_questions.set_limit(limit);
+    inbox.pending_chunks.set_limit(limit);
+}
+
+QueueCounters MessageInbox::GetInboxCounters(ContentType content_type) {
+    auto* inbox = inboxes_.Find(content_type.id());
+    if (inbox == nullptr) {
+        return {};
+    }
+    auto counters = inbox->messages.counters();
+    counters += inbox->pending_questions.counters();
+    counters += inbox->pending_chunks.counters();
+    return counters;
+}
+
+InboxMetrics MessageInbox::GetMetrics() {
+    InboxMetrics metrics{.message_box = name_, .content_types = {}};
+    inboxes_.ForEach([&metrics](Inbox& inbox) {
+        auto counters = inbox.messages.counters();
+        counters += inbox.pending_questions.counters();
+        counters += inbox.pending_chunks.counters();
+        metrics.content_types.push_back(
+            ContentTypeMetrics{.content_type = std::string(inbox.content_type.name()),
+                               .tells_received = inbox.tells_received.load(std::memory_order_relaxed),
+                               .questions_received = inbox.questions_received.load(std::memory_order_relaxed),
+                               .chunks_received = inbox.chunks_received.load(std::memory_order_relaxed),
+                               .queued_messages = inbox.messages.size(),
+                               .queued_questions = inbox.pending_questions.size(),
+                               .inbox = counters});
+    });
+    return metrics;
+}
+
+MessageInbox::Inbox& MessageInbox::GetInbox(ContentType content_type) {
+    if (auto* inbox = inboxes_.Find(content_type.id())) {
+        return *inbox;
+    }
+    std::lock_guard lock(inbox_limit_mutex_);
+    return inboxes_.GetOrCreate(content_type.id(), content_type, inbox_limit_);
+}
+
+void MessageInbox::SendAnswer(const PendingQuestion& pending_question, const Answer& answer) {
+    AnswerMessage answer_message{.message_box_name = name_,
+                                 .correlation_id = pending_question.question_message.correlation_id,
+                                 .text_correlation_id = pending_question.question_message.text_correlation_id,
+                                 .content_type = answer.content_type,
+                                 .content = answer.content};
+
+    Reply(pending_question, std::move(answer_message));
+}
+
+void MessageInbox::SendRejection(const PendingQuestion& pending_question, std::string reason) {
+    AnswerMessage answer_message{.message_box_name = name_,
+                                 .correlation_id = pending_question.question_message.correlation_id,
+                                 .text_correlation_id = pending_question.question_message.text_correlation_id,
+                                 .content_type = {},
+                                 .content = std::move(reason),
+                                 .rejected = true};
+
+    Reply(pending_question, std::move(answer_message));
+}
+
+void MessageInbox::Reply(const PendingQuestion& pending_question, AnswerMessage answer_message) {
+    if (pending_question.local_reply) {
+        pending_question.local_reply(std::move(answer_message));
+        return;
+    }
+    if (pending_question.recorder) {
+        answer_message.trace_id = pending_question.question_message.trace_id;
+        pending_question.Trace(TraceStage::AnswerQueued);
+    }
+    pending_question.answer_queue->push(IdentityMessage<AnswerMessage>{
+        .dealer_identity = pending_question.dealer_identity,
+        .message = std::move(answer_message)});
+}
+
+void MessageInbox::SendCredit(const PendingChunk& pending_chunk) {
+    if (!pending_chunk.answer_queue || pending_chunk.last) {
+        return;
+    }
+    pending_chunk.answer_queue->push(IdentityMessage<AnswerMessage>{
+        .dealer_identity = pending_chunk.dealer_identity,
+        .message = AnswerMessage{.message_box_name = name_,
+                                 .correlation_id = pending_chunk.stream_id,
+                                 .text_correlation_id = {},
+                                 .content_type = {},
+                                 .content = {},
+                                 .rejected = false,
+                                 .stream_credit = true,
+                                 .trace_id = 0}});
+}
+
+} // namespace minx::zmesh
@@ -0,0 +1,73 @@
+#include "minx/zmesh/metrics.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace minx::zmesh {
+
+std::chrono::nanoseconds HistogramSnapshot::Percentile(double percentile) const {
+    if (count == 0) {
+        return std::chrono::nanoseconds{0};
+    }
+    const auto rank = static_cast<std::uint64_t>(
+        std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(count)));
+    std::uint64_t seen = 0;
+    for (const auto& [upper_bound, bucket_count] : buckets) {
+        seen += bucket_count;
+        if (seen >= std::max<std::uint64_t>(rank, 1)) {
+            return std::min(upper_bound, max);
+        }
+    }
+    return max;
+}
+
+std::chrono::nanoseconds HistogramSnapshot::Mean() const {
+    return count == 0 ? std::chrono::nanoseconds{0} : sum / static_cast<std::int64_t>(count);
+}
+
+void LatencyHistogram::Record(std::chrono::nanoseconds value) noexcept {
+    const auto nanoseconds = static_cast<std::uint64_t>(std::max<std::int64_t>(value.count(), 0));
+    counts_[BucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    auto max = max_.load(std::memory_order_relaxed);
+    while (nanoseconds > max && !max_.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+HistogramSnapshot LatencyHistogram::Snapshot() const {
+    HistogramSnapshot snapshot;
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+        if (const auto count = counts_[i].load(std::memory_order_relaxed)) {
+            snapshot.buckets.emplace_back(std::chrono::nanoseconds{static_cast<std::int64_t>(BucketUpperBound(i))},
+                                          count);
+            snapshot.count += count;
+        }
+    }
+    snapshot.sum = std::chrono::nanoseconds{static_cast<std::int64_t>(sum_.load(std::memory_order_relaxed))};
+    snapshot.max = std::chrono::nanoseconds{static_cast<std::int64_t>(max_.load(std::memory_order_relaxed))};
+    return snapshot;
+}
+
+std::size_t LatencyHistogram::BucketIndex(std::uint64_t value) noexcept {
+    if (value < kSubBuckets) {
+        return static_cast<std::size_t>(value);
+    }
+    const auto exponent = static_cast<std::size_t>(std::bit_width(value)) - 1;
+    const auto shift = exponent - kSubBucketBits;
+    const auto sub_bucket = static_cast<std::size_t>(value >> shift) & (kSubBuckets - 1);
+    return (shift + 1) * kSubBuckets + sub_bucket;
+}
+
+std::uint64_t LatencyHistogram::BucketUpperBound(std::size_t index) noexcept {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    const auto shift = index / kSubBuckets - 1;
+    const auto sub_bucket = index % kSubBuckets;
+    const auto lower_bound = static_cast<std::uint64_t>(kSubBuckets + sub_bucket) << shift;
+    return lower_bound + ((std::uint64_t{1} << shift) - 1);
+}
+
+} // namespace minx::zmesh
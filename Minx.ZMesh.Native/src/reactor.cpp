@@ -0,0 +1,274 @@
+#include "minx/zmesh/reactor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <utility>
+
+namespace minx::zmesh {
+
+Reactor::Reactor(zmq::context_t& context, std::size_t thread_count, ErrorHandler on_error)
+    : on_error_(std::move(on_error)) {
+    thread_count = std::max<std::size_t>(thread_count, 1);
+    workers_.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>(context));
+    }
+
+    for (auto& worker : workers_) {
+        worker->thread = std::jthread([this, &worker = *worker](std::stop_token stop_token) {
+            Run(worker, stop_token);
+        });
+    }
+}
+
+Reactor::~Reactor() {
+    Stop();
+}
+
+Reactor::ChannelId Reactor::Register(zmq::socket_t socket,
+                                     Handler on_readable,
+                                     Handler on_flush,
+                                     ErrorHandler on_error) {
+    const auto channel_id = next_channel_id_.fetch_add(1, std::memory_order_relaxed);
+    auto channel = std::make_unique<Channel>(Channel{.socket = std::move(socket),
+                                                     .on_readable = std::move(on_readable),
+                                                     .on_flush = std::move(on_flush),
+                                                     .on_error = std::move(on_error)});
+
+    auto& worker = WorkerFor(channel_id);
+    {
+        std::lock_guard lock(worker.mutex);
+        worker.added.emplace_back(channel_id, std::move(channel));
+        ++worker.requested_changes;
+    }
+    worker.signal.Notify();
+
+    return channel_id;
+}
+
+void Reactor::Unregister(ChannelId channel_id) {
+    if (stopped_.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    auto& worker = WorkerFor(channel_id);
+
+    if (worker.thread.get_id() == std::this_thread::get_id()) {
+        Detach(channel_id);
+        return;
+    }
+
+    std::unique_lock lock(worker.mutex);
+    worker.removed.push_back(channel_id);
+    const auto ticket = ++worker.requested_changes;
+    lock.unlock();
+
+    worker.signal.Notify();
+
+    lock.lock();
+    worker.changes_applied.wait(lock, [&worker, ticket] { return worker.stopped || worker.applied_changes >= ticket; });
+}
+
+void Reactor::Detach(ChannelId channel_id) {
+    if (stopped_.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    auto& worker = WorkerFor(channel_id);
+    const bool owning_thread = worker.thread.get_id() == std::this_thread::get_id();
+    if (owning_thread) {
+        if (auto it = worker.channels.find(channel_id); it != worker.channels.end()) {
+            it->second->removed = true;
+        }
+    }
+    {
+        std::lock_guard lock(worker.mutex);
+        worker.removed.push_back(channel_id);
+        ++worker.requested_changes;
+    }
+    if (!owning_thread) {
+        worker.signal.Notify();
+    }
+}
+
+void Reactor::Schedule(ChannelId channel_id) {
+    auto& worker = WorkerFor(channel_id);
+    {
+        std::lock_guard lock(worker.mutex);
+        worker.scheduled.push_back(channel_id);
+    }
+    worker.signal.Notify();
+}
+
+void Reactor::ScheduleAt(ChannelId channel_id, std::chrono::steady_clock::time_point deadline) {
+    auto& deferred = WorkerFor(channel_id).deferred;
+    for (auto& entry : deferred) {
+        if (entry.second == channel_id) {
+            entry.first = std::min(entry.first, deadline);
+            return;
+        }
+    }
+    deferred.emplace_back(deadline, channel_id);
+}
+
+void Reactor::WaitWritable(ChannelId channel_id) {
+    auto& channels = WorkerFor(channel_id).channels;
+    if (auto it = channels.find(channel_id); it != channels.end()) {
+        it->second->wants_writable = true;
+    }
+}
+
+void Reactor::Stop() {
+    if (stopping_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    for (auto& worker : workers_) {
+        worker->thread.request_stop();
+    }
+
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+
+        std::lock_guard lock(worker->mutex);
+        worker->stopped = true;
+        worker->added.clear();
+        worker->channels.clear();
+        worker->changes_applied.notify_all();
+    }
+
+    stopped_.store(true, std::memory_order_release);
+}
+
+Reactor::Worker& Reactor::WorkerFor(ChannelId channel_id) {
+    return *workers_[channel_id % workers_.size()];
+}
+
+void Reactor::Run(Worker& worker, std::stop_token stop_token) {
+    std::stop_callback wake_on_stop(stop_token, [&worker] { worker.signal.Notify(); });
+
+    std::vector<zmq::pollitem_t> items{worker.signal.PollItem()};
+    std::vector<std::pair<ChannelId, Channel*>> item_channels{{0, nullptr}};
+    std::vector<ChannelId> readable;
+    std::vector<ChannelId> writable;
+    std::vector<ChannelId> scheduled;
+
+    const auto dispatch = [this, &worker](ChannelId channel_id, Handler Channel::*handler) {
+        auto it = worker.channels.find(channel_id);
+        if (it == worker.channels.end() || it->second->removed) {
+            return;
+        }
+        auto& channel = *it->second;
+        if (!(channel.*handler)) {
+            return;
+        }
+        try {
+            (channel.*handler)(channel.socket);
+        } catch (...) {
+            // The socket is closed on the next pass; the thread's other
+            // channels carry on.
+            const auto error = std::current_exception();
+            Unregister(channel_id);
+            ReportError(on_error_, error);
+            if (channel.on_error) {
+                channel.on_error(error);
+            }
+        }
+    };
+
+    while (!stop_token.stop_requested()) {
+        bool changed = false;
+        {
+            std::lock_guard lock(worker.mutex);
+
+            for (auto& [channel_id, channel] : worker.added) {
+                worker.channels.emplace(channel_id, std::move(channel));
+            }
+            for (const auto channel_id : worker.removed) {
+                worker.channels.erase(channel_id);
+            }
+            changed = !worker.added.empty() || !worker.removed.empty();
+            worker.added.clear();
+            worker.removed.clear();
+
+            scheduled.swap(worker.scheduled);
+
+            if (worker.applied_changes != worker.requested_changes) {
+                worker.applied_changes = worker.requested_changes;
+                worker.changes_applied.notify_all();
+            }
+        }
+
+        if (changed) {
+            items.resize(1);
+            item_channels.resize(1);
+            for (auto& [channel_id, channel] : worker.channels) {
+                items.push_back({channel->socket.handle(), 0, ZMQ_POLLIN, 0});
+                item_channels.emplace_back(channel_id, channel.get());
+            }
+        }
+
+        for (const auto channel_id : readable) {
+            dispatch(channel_id, &Channel::on_readable);
+        }
+        readable.clear();
+
+        for (const auto channel_id : writable) {
+            dispatch(channel_id, &Channel::on_flush);
+        }
+        writable.clear();
+
+        if (!worker.deferred.empty()) {
+            const auto now = std::chrono::steady_clock::now();
+            std::erase_if(worker.deferred, [&scheduled, now](const auto& entry) {
+                if (entry.first > now) {
+                    return false;
+                }
+                scheduled.push_back(entry.second);
+                return true;
+            });
+        }
+
+        for (const auto channel_id : scheduled) {
+            dispatch(channel_id, &Channel::on_flush);
+        }
+        scheduled.clear();
+
+        if (stop_token.stop_requested()) {
+            break;
+        }
+
+        auto timeout = std::chrono::milliseconds{-1};
+        if (!worker.deferred.empty()) {
+            const auto earliest = std::min_element(worker.deferred.begin(), worker.deferred.end())->first;
+            // Rounded up: a deadline under a millisecond away would otherwise
+            // poll with no timeout and spin until it passed.
+            const auto remaining = earliest - std::chrono::steady_clock::now();
+            timeout = std::max(std::chrono::ceil<std::chrono::milliseconds>(remaining), std::chrono::milliseconds{0});
+        }
+        for (std::size_t i = 1; i < items.size(); ++i) {
+            const auto writable_events = item_channels[i].second->wants_writable ? ZMQ_POLLOUT : 0;
+            items[i].events = static_cast<short>(ZMQ_POLLIN | writable_events);
+        }
+        zmq::poll(items.data(), items.size(), timeout);
+
+        if (items[0].revents & ZMQ_POLLIN) {
+            worker.signal.Consume();
+        }
+        for (std::size_t i = 1; i < items.size(); ++i) {
+            const auto& [channel_id, channel] = item_channels[i];
+            if (items[i].revents & ZMQ_POLLIN) {
+                readable.push_back(channel_id);
+            }
+            if (items[i].revents & ZMQ_POLLOUT) {
+                channel->wants_writable = false;
+                writable.push_back(channel_id);
+            }
+        }
+    }
+}
+
+} // namespace minx::zmesh
@@ -0,0 +1,119 @@
+#include "minx/zmesh/router_pipeline.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <string_view>
+#include <utility>
+
+namespace minx::zmesh {
+
+namespace {
+
+constexpr int kSpinRounds = 64;
+
+// The box name is the third frame in both the binary and the text format.
+constexpr std::size_t kBoxFrame = 2;
+
+} // namespace
+
+RouterPipeline::RouterPipeline(std::size_t worker_count,
+                               std::size_t ring_capacity,
+                               Handler handler,
+                               ErrorHandler on_error)
+    : handler_(std::move(handler)),
+      on_error_(std::move(on_error)) {
+    worker_count = std::max<std::size_t>(worker_count, 1);
+    workers_.reserve(worker_count);
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>(ring_capacity));
+    }
+
+    for (auto& worker : workers_) {
+        worker->thread = std::jthread([this, &worker = *worker](std::stop_token stop_token) { Run(worker, stop_token); });
+    }
+}
+
+RouterPipeline::~RouterPipeline() {
+    Stop();
+}
+
+void RouterPipeline::Submit(RouterFrames& message) {
+    std::size_t index = 0;
+    if (workers_.size() > 1 && message.count > kBoxFrame) {
+        const auto& box = message.frames[kBoxFrame];
+        index = std::hash<std::string_view>{}(std::string_view(static_cast<const char*>(box.data()), box.size())) %
+                workers_.size();
+    }
+
+    auto& worker = *workers_[index];
+    while (!worker.ring.try_push(message)) {
+        if (stopped_.load(std::memory_order_acquire)) {
+            return;
+        }
+        Wake(worker);
+        std::this_thread::yield();
+    }
+
+    // Pairs with the fence in Run(): either the worker is seen sleeping here,
+    // or it sees the message before it waits.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (worker.sleeping.load(std::memory_order_relaxed)) {
+        Wake(worker);
+    }
+}
+
+void RouterPipeline::Stop() {
+    if (stopped_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    for (auto& worker : workers_) {
+        worker->thread.request_stop();
+        Wake(*worker);
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void RouterPipeline::Wake(Worker& worker) {
+    worker.wakeups.fetch_add(1, std::memory_order_release);
+    worker.wakeups.notify_one();
+}
+
+void RouterPipeline::Run(Worker& worker, std::stop_token stop_token) {
+    RouterFrames message;
+    while (!stop_token.stop_requested()) {
+        if (worker.ring.try_pop(message)) {
+            try {
+                handler_(message);
+            } catch (...) {
+                // A malformed message must not take the worker down.
+                ReportError(on_error_, std::current_exception());
+            }
+            continue;
+        }
+
+        bool found = false;
+        for (int i = 0; i < kSpinRounds && !found; ++i) {
+            std::this_thread::yield();
+            found = !worker.ring.empty();
+        }
+        if (found) {
+            continue;
+        }
+
+        const auto wakeups = worker.wakeups.load(std::memory_order_acquire);
+        worker.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (worker.ring.empty() && !stop_token.stop_requested()) {
+            worker.wakeups.wait(wakeups, std::memory_order_acquire);
+        }
+        worker.sleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+} // namespace minx::zmesh
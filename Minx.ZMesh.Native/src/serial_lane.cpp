@@ -0,0 +1,50 @@
+#include "minx/zmesh/serial_lane.hpp"
+
+#include <exception>
+#include <thread>
+#include <utility>
+
+namespace minx::zmesh {
+
+namespace {
+
+constexpr std::size_t kDrainBatch = 64;
+
+} // namespace
+
+SerialLane::SerialLane(Executor& executor)
+    : executor_(executor) {}
+
+void SerialLane::Post(Executor::Task task) {
+    tasks_.push(std::move(task));
+    if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+        executor_.Post([self = shared_from_this()] { self->Drain(); });
+    }
+}
+
+void SerialLane::Drain() {
+    for (std::size_t ran = 0;;) {
+        Executor::Task task;
+        // pending_ counts the task, but its push may still be in flight.
+        while (!tasks_.try_pop(task)) {
+            std::this_thread::yield();
+        }
+
+        // Keep the lane running for the tasks behind this one.
+        try {
+            task();
+        } catch (...) {
+            executor_.ReportError(std::current_exception());
+        }
+
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            return;
+        }
+        if (++ran == kDrainBatch) {
+            executor_.Post([self = shared_from_this()] { self->Drain(); });
+            return;
+        }
+    }
+}
+
+} // namespace minx::zmesh
@@ -0,0 +1,274 @@
+#include "minx/zmesh/timer_wheel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <utility>
+
+namespace minx::zmesh {
+
+TimerWheel::TimerWheel(std::chrono::milliseconds resolution)
+    : resolution_(std::max<std::chrono::steady_clock::duration>(resolution, std::chrono::milliseconds{1})),
+      epoch_(std::chrono::steady_clock::now()) {
+    for (auto& level : levels_) {
+        level.heads.fill(kNil);
+    }
+
+    thread_ = std::jthread([this](std::stop_token stop_token) { Run(stop_token); });
+}
+
+TimerWheel::~TimerWheel() {
+    Stop();
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(std::chrono::milliseconds delay, Callback callback) {
+    // Round the deadline up to a tick boundary so timers never fire early.
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::max(std::chrono::steady_clock::duration(delay), std::chrono::steady_clock::duration::zero());
+    const auto expiry = static_cast<std::uint64_t>((deadline - epoch_ + resolution_ - std::chrono::steady_clock::duration{1}) /
+                                                   resolution_);
+
+    std::lock_guard lock(mutex_);
+
+    const auto now_tick = NowTick();
+    if (active_count_ == 0) {
+        // Nothing is pending, so the wheel can skip the idle ticks outright.
+        current_tick_ = std::max(current_tick_, now_tick);
+    }
+
+    std::uint32_t index;
+    if (!free_timers_.empty()) {
+        index = free_timers_.back();
+        free_timers_.pop_back();
+    } else {
+        index = static_cast<std::uint32_t>(timers_.size());
+        timers_.emplace_back();
+        timers_.back().generation = 1;
+    }
+
+    auto& timer = timers_[index];
+    timer.callback = std::move(callback);
+    timer.expiry = expiry;
+    timer.active = true;
+    Insert(index);
+    ++active_count_;
+
+    if (timer.expiry < next_wake_tick_) {
+        next_wake_tick_ = timer.expiry;
+        cv_.notify_one();
+    }
+
+    return (static_cast<TimerId>(timer.generation) << 32) | index;
+}
+
+bool TimerWheel::Cancel(TimerId timer_id) {
+    if (timer_id == kInvalidTimer) {
+        return false;
+    }
+
+    const auto index = static_cast<std::uint32_t>(timer_id & 0xFFFFFFFFu);
+    const auto generation = static_cast<std::uint32_t>(timer_id >> 32);
+
+    Callback discarded;
+    {
+        std::lock_guard lock(mutex_);
+        if (index >= timers_.size()) {
+            return false;
+        }
+
+        auto& timer = timers_[index];
+        if (!timer.active || timer.generation != generation) {
+            return false;
+        }
+
+        Unlink(index);
+        discarded = std::move(timer.callback);
+        Release(index);
+    }
+    return true;
+}
+
+void TimerWheel::Stop() {
+    if (thread_.joinable()) {
+        thread_.request_stop();
+        thread_.join();
+    }
+}
+
+std::uint64_t TimerWheel::NowTick() const {
+    return static_cast<std::uint64_t>((std::chrono::steady_clock::now() - epoch_) / resolution_);
+}
+
+void TimerWheel::Insert(std::uint32_t index) {
+    auto& timer = timers_[index];
+
+    const auto expiry = std::max(timer.expiry, current_tick_);
+    auto delta = expiry - current_tick_;
+
+    int level = 0;
+    while (level < kLevels - 1 && delta >= (std::uint64_t{1} << (kSlotBits * (level + 1)))) {
+        ++level;
+    }
+
+    constexpr auto max_delta = (std::uint64_t{1} << (kSlotBits * kLevels)) - 1;
+    const auto slot_tick = current_tick_ + std::min(delta, max_delta);
+    const auto slot = static_cast<std::uint8_t>((slot_tick >> (kSlotBits * level)) & kSlotMask);
+
+    auto& wheel_level = levels_[level];
+    timer.level = static_cast<std::uint8_t>(level);
+    timer.slot = slot;
+    timer.prev = kNil;
+    timer.next = wheel_level.heads[slot];
+    if (timer.next != kNil) {
+        timers_[timer.next].prev = index;
+    }
+    wheel_level.heads[slot] = index;
+    wheel_level.occupied |= std::uint64_t{1} << slot;
+}
+
+void TimerWheel::Unlink(std::uint32_t index) {
+    auto& timer = timers_[index];
+    auto& wheel_level = levels_[timer.level];
+
+    if (timer.prev != kNil) {
+        timers_[timer.prev].next = timer.next;
+    } else {
+        wheel_level.heads[timer.slot] = timer.next;
+        if (timer.next == kNil) {
+            wheel_level.occupied &= ~(std::uint64_t{1} << timer.slot);
+        }
+    }
+    if (timer.next != kNil) {
+        timers_[timer.next].prev = timer.prev;
+    }
+    timer.prev = kNil;
+    timer.next = kNil;
+}
+
+void TimerWheel::Release(std::uint32_t index) {
+    auto& timer = timers_[index];
+    timer.active = false;
+    if (++timer.generation == 0) {
+        timer.generation = 1;
+    }
+    free_timers_.push_back(index);
+    --active_count_;
+}
+
+void TimerWheel::Cascade(int level) {
+    auto& wheel_level = levels_[level];
+    const auto slot = (current_tick_ >> (kSlotBits * level)) & kSlotMask;
+
+    auto index = wheel_level.heads[slot];
+    wheel_level.heads[slot] = kNil;
+    wheel_level.occupied &= ~(std::uint64_t{1} << slot);
+
+    while (index != kNil) {
+        const auto next = timers_[index].next;
+        Insert(index);
+        index = next;
+    }
+}
+
+void TimerWheel::Advance(std::uint64_t target_tick, std::vector<Callback>& expired) {
+    while (current_tick_ <= target_tick && active_count_ > 0) {
+        if ((current_tick_ & kSlotMask) == 0) {
+            for (int level = 1; level < kLevels; ++level) {
+                Cascade(level);
+                if (((current_tick_ >> (kSlotBits * level)) & kSlotMask) != 0) {
+                    break;
+                }
+            }
+        }
+
+        auto& first_level = levels_[0];
+        const auto slot = current_tick_ & kSlotMask;
+        auto index = first_level.heads[slot];
+        first_level.heads[slot] = kNil;
+        first_level.occupied &= ~(std::uint64_t{1} << slot);
+
+        while (index != kNil) {
+            auto& timer = timers_[index];
+            const auto next = timer.next;
+            timer.prev = kNil;
+            timer.next = kNil;
+            expired.push_back(std::move(timer.callback));
+            Release(index);
+            index = next;
+        }
+
+        ++current_tick_;
+    }
+
+    if (active_count_ == 0) {
+        current_tick_ = std::max(current_tick_, target_tick + 1);
+    }
+}
+
+std::uint64_t TimerWheel::NextWakeTick() const {
+    if (active_count_ == 0) {
+        return std::numeric_limits<std::uint64_t>::max();
+    }
+
+    // A slot's timers fire (first level) or cascade down (higher levels) on
+    // the tick its span starts, so the wheel sleeps until the earliest such
+    // tick across all levels.
+    auto wake_tick = std::numeric_limits<std::uint64_t>::max();
+    for (int level = 0; level < kLevels; ++level) {
+        const auto occupied = levels_[level].occupied;
+        if (occupied == 0) {
+            continue;
+        }
+
+        const auto shift = kSlotBits * level;
+        const auto turn_ticks = std::uint64_t{1} << (shift + kSlotBits);
+        const auto index = (current_tick_ >> shift) & kSlotMask;
+        // The current slot is still ahead only if its span starts on this
+        // tick; otherwise it has cascaded and holds timers for the next turn.
+        const auto started = (current_tick_ & ((std::uint64_t{1} << shift) - 1)) != 0;
+        const auto first = index + (started ? 1 : 0);
+        const auto ahead = first < kSlots ? occupied >> first : 0;
+
+        auto turn = current_tick_ & ~(turn_ticks - 1);
+        std::uint64_t slot;
+        if (ahead != 0) {
+            slot = first + static_cast<std::uint64_t>(std::countr_zero(ahead));
+        } else {
+            slot = static_cast<std::uint64_t>(std::countr_zero(occupied));
+            turn += turn_ticks;
+        }
+        wake_tick = std::min(wake_tick, turn + (slot << shift));
+    }
+    return wake_tick;
+}
+
+void TimerWheel::Run(std::stop_token stop_token) {
+    std::vector<Callback> expired;
+
+    std::unique_lock lock(mutex_);
+    while (!stop_token.stop_requested()) {
+        Advance(NowTick(), expired);
+
+        if (!expired.empty()) {
+            lock.unlock();
+            for (auto& callback : expired) {
+                callback();
+            }
+            expired.clear();
+            lock.lock();
+            continue;
+        }
+
+        const auto wake_tick = NextWakeTick();
+        next_wake_tick_ = wake_tick;
+
+        const auto rescheduled = [this, wake_tick] { return next_wake_tick_ < wake_tick; };
+        if (wake_tick == std::numeric_limits<std::uint64_t>::max()) {
+            cv_.wait(lock, stop_token, rescheduled);
+        } else {
+            cv_.wait_until(lock, stop_token, epoch_ + resolution_ * static_cast<std::int64_t>(wake_tick), rescheduled);
+        }
+    }
+}
+
+} // namespace minx::zmesh
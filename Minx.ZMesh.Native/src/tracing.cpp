@@ -0,0 +1,183 @@
+#include "minx/zmesh/tracing.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <random>
+#include <utility>
+
+namespace minx::zmesh {
+
+namespace {
+
+std::atomic<std::uint64_t> next_recorder_id{1};
+
+TraceId RandomTraceIdBase() {
+    std::random_device rd;
+    std::mt19937_64 random_engine(rd());
+    return random_engine();
+}
+
+std::int64_t ToNanoseconds(std::chrono::steady_clock::time_point at) noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(at.time_since_epoch()).count();
+}
+
+void WriteLittleEndian(std::ostream& out, std::uint64_t value, std::size_t bytes) {
+    char buffer[8];
+    for (std::size_t i = 0; i < bytes; ++i) {
+        buffer[i] = static_cast<char>(value >> (8 * i));
+    }
+    out.write(buffer, static_cast<std::streamsize>(bytes));
+}
+
+} // namespace
+
+// Written only by its thread. Entries are atomics so a concurrent Events() reads
+// them without a data race; head is published after the entry it covers.
+struct FlightRecorder::Ring {
+    struct Entry {
+        std::atomic<TraceId> trace_id{0};
+        std::atomic<std::int64_t> at{0};
+        std::atomic<std::uint8_t> stage{0};
+    };
+
+    Ring(std::size_t capacity, std::uint32_t ring_thread)
+        : entries(std::make_unique<Entry[]>(capacity)),
+          mask(capacity - 1),
+          thread(ring_thread) {}
+
+    std::unique_ptr<Entry[]> entries;
+    const std::size_t mask;
+    const std::uint32_t thread;
+    std::atomic<std::uint64_t> head{0};
+};
+
+FlightRecorder::FlightRecorder(TracingOptions options)
+    : sample_every_(options.sample_every),
+      ring_capacity_(std::bit_ceil(std::max<std::size_t>(options.ring_capacity, 2))),
+      id_(next_recorder_id.fetch_add(1, std::memory_order_relaxed)),
+      trace_id_base_(RandomTraceIdBase()) {}
+
+FlightRecorder::~FlightRecorder() = default;
+
+TraceId FlightRecorder::Sample() noexcept {
+    if (sample_every_ == 0) {
+        return 0;
+    }
+    const auto sample = samples_.fetch_add(1, std::memory_order_relaxed);
+    if (sample % sample_every_ != 0) {
+        return 0;
+    }
+    const auto trace_id = trace_id_base_ + sample;
+    return trace_id != 0 ? trace_id : 1;
+}
+
+void FlightRecorder::Record(TraceId trace_id, TraceStage stage) noexcept {
+    if (trace_id != 0) {
+        Record(trace_id, stage, std::chrono::steady_clock::now());
+    }
+}
+
+void FlightRecorder::Record(TraceId trace_id, TraceStage stage, std::chrono::steady_clock::time_point at) noexcept {
+    if (trace_id == 0) {
+        return;
+    }
+    auto& ring = ThreadRing();
+    const auto head = ring.head.load(std::memory_order_relaxed);
+    auto& entry = ring.entries[head & ring.mask];
+    entry.trace_id.store(trace_id, std::memory_order_relaxed);
+    entry.at.store(ToNanoseconds(at), std::memory_order_relaxed);
+    entry.stage.store(static_cast<std::uint8_t>(stage), std::memory_order_relaxed);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+FlightRecorder::Ring& FlightRecorder::ThreadRing() {
+    // Rings of every recorder this thread has recorded into, by recorder id.
+    // Ids are never reused, so entries of destroyed recorders never match.
+    thread_local std::vector<std::pair<std::uint64_t, Ring*>> thread_rings;
+    for (const auto& [recorder_id, ring] : thread_rings) {
+        if (recorder_id == id_) {
+            return *ring;
+        }
+    }
+
+    std::lock_guard lock(rings_mutex_);
+    auto ring = std::make_unique<Ring>(ring_capacity_, static_cast<std::uint32_t>(rings_.size()));
+    thread_rings.emplace_back(id_, ring.get());
+    return *rings_.emplace_back(std::move(ring));
+}
+
+std::vector<TraceEvent> FlightRecorder::Events() const {
+    std::vector<TraceEvent> events;
+    std::lock_guard lock(rings_mutex_);
+    for (const auto& ring : rings_) {
+        const auto head = ring->head.load(std::memory_order_acquire);
+        const auto first = head > ring_capacity_ ? head - ring_capacity_ : 0;
+        const auto copied_from = events.size();
+        for (auto index = first; index < head; ++index) {
+            const auto& entry = ring->entries[index & ring->mask];
+            events.push_back(TraceEvent{
+                .trace_id = entry.trace_id.load(std::memory_order_relaxed),
+                .stage = static_cast<TraceStage>(entry.stage.load(std::memory_order_relaxed)),
+                .thread = ring->thread,
+                .at = std::chrono::steady_clock::time_point(
+                    std::chrono::nanoseconds(entry.at.load(std::memory_order_relaxed)))});
+        }
+
+        // The slot of index i is reused by index i + capacity, so entries the
+        // writer may have reached since, including the one it may be writing
+        // now, are dropped from the front.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const auto new_head = ring->head.load(std::memory_order_relaxed);
+        if (new_head >= first + ring_capacity_) {
+            const auto overwritten = std::min<std::uint64_t>(new_head - ring_capacity_ - first + 1, head - first);
+            events.erase(events.begin() + static_cast<std::ptrdiff_t>(copied_from),
+                         events.begin() + static_cast<std::ptrdiff_t>(copied_from + overwritten));
+        }
+    }
+    return events;
+}
+
+void FlightRecorder::Dump(std::ostream& out, TraceFormat format) const {
+    const auto events = Events();
+
+    if (format == TraceFormat::Binary) {
+        out.write("ZMTR", 4);
+        WriteLittleEndian(out, 1, 4);
+        WriteLittleEndian(out, events.size(), 8);
+        for (const auto& event : events) {
+            WriteLittleEndian(out, event.trace_id, 8);
+            WriteLittleEndian(out, static_cast<std::uint64_t>(ToNanoseconds(event.at)), 8);
+            WriteLittleEndian(out, event.thread, 4);
+            WriteLittleEndian(out, static_cast<std::uint8_t>(event.stage), 1);
+        }
+        return;
+    }
+
+    // Events of one recorder share a pid, so the dumps of several meshes can be
+    // merged into one trace.
+    const auto pid = trace_id_base_ >> 44;
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto& event : events) {
+        const auto at = ToNanoseconds(event.at);
+        char line[256];
+        std::snprintf(line,
+                      sizeof(line),
+                      "%s\n{\"name\":\"%.*s\",\"cat\":\"zmesh\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lld.%03lld,"
+                      "\"pid\":%llu,\"tid\":%u,\"args\":{\"trace\":\"%016llx\"}}",
+                      first ? "" : ",",
+                      static_cast<int>(to_string(event.stage).size()),
+                      to_string(event.stage).data(),
+                      static_cast<long long>(at / 1000),
+                      static_cast<long long>(at % 1000),
+                      static_cast<unsigned long long>(pid),
+                      event.thread,
+                      static_cast<unsigned long long>(event.trace_id));
+        out << line;
+        first = false;
+    }
+    out << "\n]}\n";
+}
+
+} // namespace minx::zmesh
@@ -0,0 +1,52 @@
+#include "minx/zmesh/wakeup_signal.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace minx::zmesh {
+
+namespace {
+
+std::string NextWakeupEndpoint() {
+    static std::atomic<std::uint64_t> counter{0};
+    return "inproc://minx-zmesh-wakeup-" + std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+}
+
+} // namespace
+
+WakeupSignal::WakeupSignal(zmq::context_t& context)
+    : receiver_(context, zmq::socket_type::pair),
+      sender_(context, zmq::socket_type::pair) {
+    receiver_.set(zmq::sockopt::linger, 0);
+    sender_.set(zmq::sockopt::linger, 0);
+
+    const auto endpoint = NextWakeupEndpoint();
+    receiver_.bind(endpoint);
+    sender_.connect(endpoint);
+}
+
+void WakeupSignal::Notify() {
+    if (pending_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    std::lock_guard lock(sender_mutex_);
+    const char signal = 0;
+    (void)sender_.send(zmq::buffer(&signal, sizeof(signal)), zmq::send_flags::dontwait);
+}
+
+void WakeupSignal::Consume() {
+    zmq::message_t frame;
+    while (receiver_.recv(frame, zmq::recv_flags::dontwait)) {
+    }
+
+    // Re-arm before the caller drains its queues so a producer that pushes
+    // after the drain has started is guaranteed to send a fresh signal.
+    pending_.store(false, std::memory_order_release);
+}
+
+zmq::pollitem_t WakeupSignal::PollItem() {
+    return {receiver_.handle(), 0, ZMQ_POLLIN, 0};
+}
+
+} // namespace minx::zmesh
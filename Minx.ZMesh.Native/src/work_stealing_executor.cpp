@@ -0,0 +1,135 @@
+#include "minx/zmesh/work_stealing_executor.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace minx::zmesh {
+
+namespace {
+
+struct CurrentWorker {
+    const void* executor{nullptr};
+    std::size_t index{0};
+};
+
+thread_local CurrentWorker current_worker;
+
+constexpr int kSpinRounds = 64;
+
+} // namespace
+
+WorkStealingExecutor::WorkStealingExecutor(std::size_t thread_count, ErrorHandler on_error)
+    : Executor(std::move(on_error)) {
+    thread_count = std::max<std::size_t>(thread_count, 1);
+    workers_.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+
+    for (std::size_t i = 0; i < thread_count; ++i) {
+        workers_[i]->thread = std::jthread([this, i](std::stop_token stop_token) { Run(i, stop_token); });
+    }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+    Stop();
+}
+
+void WorkStealingExecutor::Post(Task task) {
+    if (stopped_.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    const auto index = current_worker.executor == this
+                           ? current_worker.index
+                           : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    {
+        auto& worker = *workers_[index];
+        std::lock_guard lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+
+    // Pairs with the sleepers_ increment in Run(): either a sleeping worker is
+    // seen here, or the worker sees queued_ before it waits.
+    queued_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+        { std::lock_guard lock(sleep_mutex_); }
+        sleep_cv_.notify_one();
+    }
+}
+
+void WorkStealingExecutor::Stop() {
+    if (stopped_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    for (auto& worker : workers_) {
+        worker->thread.request_stop();
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+        std::lock_guard lock(worker->mutex);
+        worker->tasks.clear();
+    }
+}
+
+bool WorkStealingExecutor::TryTake(std::size_t index, Task& task) {
+    {
+        auto& own = *workers_[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+
+    for (std::size_t offset = 1; offset < workers_.size(); ++offset) {
+        auto& victim = *workers_[(index + offset) % workers_.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingExecutor::Run(std::size_t index, std::stop_token stop_token) {
+    current_worker = CurrentWorker{.executor = this, .index = index};
+
+    int idle_rounds = 0;
+    while (!stop_token.stop_requested()) {
+        Task task;
+        if (TryTake(index, task)) {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            idle_rounds = 0;
+            // A throwing handler must not take the worker down with it.
+            try {
+                task();
+            } catch (...) {
+                ReportError(std::current_exception());
+            }
+            continue;
+        }
+
+        if (++idle_rounds < kSpinRounds) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock lock(sleep_mutex_);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        sleep_cv_.wait(lock, stop_token, [this] { return queued_.load(std::memory_order_seq_cst) > 0; });
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        idle_rounds = 0;
+    }
+
+    current_worker = CurrentWorker{};
+}
+
+} // namespace minx::zmesh
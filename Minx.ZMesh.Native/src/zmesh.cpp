@@ -1,28 +1,35 @@
 #include "minx/zmesh/zmesh.hpp"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include "minx/zmesh/abstract_message_box.hpp"
+#include "minx/zmesh/compressor.hpp"
+#include "minx/zmesh/content_type.hpp"
+#include "minx/zmesh/endpoint.hpp"
+#include "minx/zmesh/error_handler.hpp"
+#include "minx/zmesh/message_inbox.hpp"
+#include "minx/zmesh/metrics.hpp"
+#include "minx/zmesh/pending_chunk.hpp"
 #include "minx/zmesh/pending_question.hpp"
 #include "minx/zmesh/types.hpp"
+#include "minx/zmesh/wire_format.hpp"
 
 namespace minx::zmesh {
 
 namespace {
 
-void EnsureSend(zmq::socket_t& socket,
-                const zmq::const_buffer& buffer,
-                zmq::send_flags flags,
-                std::string_view operation) {
-    const auto sent = socket.send(buffer, flags);
-    if (!sent) {
-        throw std::runtime_error("ZeroMQ send failed during " + std::string(operation));
-    }
-}
+// How soon a router send that hit a full peer is first retried, and the
+// longest the delay grows to while the peer stays full.
+constexpr std::chrono::milliseconds kRouterRetryDelay{1};
+constexpr std::chrono::milliseconds kMaxRouterRetryDelay{64};
 
 void EnsureRecv(zmq::socket_t& socket,
                 zmq::message_t& frame,
@@ -34,6 +41,21 @@ void EnsureRecv(zmq::socket_t& socket,
     }
 }
 
+template <std::size_t N>
+std::size_t RecvMultipart(zmq::socket_t& socket, std::array<zmq::message_t, N>& frames, std::string_view operation) {
+    // Frames beyond N are drained and dropped so the next read starts clean.
+    std::size_t count = 0;
+    zmq::message_t discarded;
+    for (;;) {
+        auto& frame = count < N ? frames[count] : discarded;
+        EnsureRecv(socket, frame, operation);
+        ++count;
+        if (!frame.more()) {
+            return count;
+        }
+    }
+}
+
 std::string FrameToString(const zmq::message_t& frame, bool trim_nulls = true) {
     std::string value(static_cast<const char*>(frame.data()), frame.size());
     if (trim_nulls) {
@@ -44,37 +66,87 @@ std::string FrameToString(const zmq::message_t& frame, bool trim_nulls = true) {
     return value;
 }
 
+std::string_view FrameToView(const zmq::message_t& frame) {
+    std::string_view value(static_cast<const char*>(frame.data()), frame.size());
+    while (!value.empty() && value.back() == '\0') {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
 } // namespace
 
 ZMesh::ZMesh(std::optional<std::string> address,
-             std::unordered_map<std::string, std::string> system_map)
-    : context_(1),
+             std::unordered_map<std::string, std::string> system_map,
+             ZMeshOptions options)
+    : context_(options.context),
+      endpoint_(address && !address->empty() ? ToEndpoint(*address) : std::string()),
       system_map_(std::move(system_map)),
-      answer_queue_(std::make_shared<AnswerQueue>()) {
-    if (address && !address->empty()) {
-        router_ = std::make_unique<zmq::socket_t>(context_, zmq::socket_type::router);
-        router_->set(zmq::sockopt::linger, 0);
-        router_->bind("tcp://" + *address);
-        router_thread_ = std::jthread([this](std::stop_token stop_token) { RouterLoop(stop_token); });
+      options_(std::move(options)),
+      compressor_(options_.compression),
+      recorder_(std::make_shared<FlightRecorder>(options_.tracing)),
+      executor_(options_.handler_executor),
+      answer_queue_(std::make_shared<AnswerQueue>(
+          [this] {
+              if (router_channel_) {
+                  reactor_->Schedule(*router_channel_);
+              }
+          },
+          options_.single_consumer_queue)) {
+    if (!context_) {
+        context_ = std::make_shared<zmq::context_t>(1);
+        if (options_.max_sockets > 0) {
+            context_->set(zmq::ctxopt::max_sockets, options_.max_sockets);
+        }
     }
-}
 
-ZMesh::~ZMesh() {
-    if (router_thread_.joinable()) {
-        router_thread_.request_stop();
-        answer_queue_->close();
-        router_thread_.join();
+    if (!executor_) {
+        owned_executor_ = std::make_shared<WorkStealingExecutor>(options_.handler_threads, options_.on_error);
+        executor_ = owned_executor_;
     }
 
-    if (router_) {
-        try {
-            router_->close();
-        } catch (...) {
+    reactor_ = std::make_unique<Reactor>(*context_, options_.reactor_threads, options_.on_error);
+
+    if (!endpoint_.empty()) {
+        if (options_.router_workers > 0) {
+            pipeline_ = std::make_unique<RouterPipeline>(options_.router_workers,
+                                                         options_.router_ring_capacity,
+                                                         [this](RouterFrames& message) { DispatchFrames(message); },
+                                                         options_.on_error);
         }
+
+        zmq::socket_t router(*context_, zmq::socket_type::router);
+        router.set(zmq::sockopt::linger, 0);
+        // A dealer whose pipe is at the high-water mark makes sends fail with
+        // EAGAIN instead of silently dropping the answer; see SendToPeer.
+        router.set(zmq::sockopt::router_mandatory, true);
+        router.bind(endpoint_);
+        router_channel_ = reactor_->Register(
+            std::move(router),
+            [this](zmq::socket_t& socket) { ReceiveFromRouter(socket); },
+            [this](zmq::socket_t& socket) { SendPendingAnswers(socket); },
+            // Answers would pile up for a router that can no longer send them.
+            [this](std::exception_ptr) { answer_queue_->close(); });
     }
+}
 
-    std::lock_guard lock(message_boxes_mutex_);
-    message_boxes_.clear();
+ZMesh::~ZMesh() {
+    answer_queue_->close();
+    reactor_->Stop();
+    if (pipeline_) {
+        pipeline_->Stop();
+    }
+    timers_.Stop();
+    if (owned_executor_) {
+        owned_executor_->Stop();
+    }
+
+    {
+        std::lock_guard lock(message_boxes_mutex_);
+        message_boxes_.clear();
+    }
+    std::lock_guard lock(inboxes_mutex_);
+    inboxes_.clear();
 }
 
 std::shared_ptr<IAbstractMessageBox> ZMesh::At(const std::string& name) {
@@ -89,140 +161,457 @@ std::shared_ptr<IAbstractMessageBox> ZMesh::At(const std::string& name) {
         throw std::invalid_argument("Unknown message box: " + name);
     }
 
-    auto message_box = std::make_shared<AbstractMessageBox>(name, map_it->second, context_, answer_queue_);
+    const bool local = !endpoint_.empty() && ToEndpoint(map_it->second) == endpoint_;
+    auto message_box = std::make_shared<AbstractMessageBox>(name,
+                                                            map_it->second,
+                                                            *context_,
+                                                            *reactor_,
+                                                            timers_,
+                                                            FindOrCreateInbox(name),
+                                                            compressor_,
+                                                            recorder_,
+                                                            options_.single_consumer_queue,
+                                                            options_.outgoing_limit,
+                                                            options_.tell_batching,
+                                                            options_.streams,
+                                                            local,
+                                                            options_.on_error);
     auto [inserted_it, inserted] = message_boxes_.emplace(name, std::move(message_box));
     (void)inserted;
     return inserted_it->second;
 }
 
-void ZMesh::RouterLoop(std::stop_token stop_token) {
-    while (!stop_token.stop_requested()) {
-        if (router_) {
-            zmq::pollitem_t items[] = {{*router_, 0, ZMQ_POLLIN, 0}};
-            zmq::poll(items, 1, std::chrono::milliseconds{10});
-
-            if (items[0].revents & ZMQ_POLLIN) {
-                zmq::message_t identity_frame;
-                zmq::message_t message_box_name_frame;
-                zmq::message_t message_type_frame;
-                zmq::message_t correlation_frame;
-                zmq::message_t content_type_frame;
-                zmq::message_t content_frame;
-
-                EnsureRecv(*router_, identity_frame, "request identity");
-                EnsureRecv(*router_, message_type_frame, "request type");
-                EnsureRecv(*router_, message_box_name_frame, "request message box name");
-                EnsureRecv(*router_, correlation_frame, "request correlation id");
-                EnsureRecv(*router_, content_type_frame, "request content type");
-                EnsureRecv(*router_, content_frame, "request content");
-
-                const std::string dealer_identity(static_cast<char*>(identity_frame.data()), identity_frame.size());
-                const std::string message_box_name = FrameToString(message_box_name_frame);
-                const std::string message_type_string = FrameToString(message_type_frame);
-                const std::string correlation_id = FrameToString(correlation_frame);
-                const std::string content_type = FrameToString(content_type_frame);
-                const std::string content = FrameToString(content_frame, false);
-
-                MessageType message_type;
-                try {
-                    message_type = message_type_from_string(message_type_string);
-                } catch (...) {
-                    continue;
-                }
-
-                if (message_type == MessageType::Tell) {
-                    DispatchTell(message_box_name, content_type, content);
-                } else if (message_type == MessageType::Question) {
-                    DispatchQuestion(dealer_identity, message_box_name, correlation_id, content_type, content);
-                }
-            }
+MeshMetrics ZMesh::GetMetrics() {
+    std::vector<std::shared_ptr<AbstractMessageBox>> message_boxes;
+    {
+        std::lock_guard lock(message_boxes_mutex_);
+        message_boxes.reserve(message_boxes_.size());
+        for (const auto& [name, message_box] : message_boxes_) {
+            message_boxes.push_back(message_box);
+        }
+    }
+    std::vector<std::shared_ptr<MessageInbox>> inboxes;
+    {
+        std::shared_lock lock(inboxes_mutex_);
+        inboxes.reserve(inboxes_.size());
+        for (const auto& [name, inbox] : inboxes_) {
+            inboxes.push_back(inbox);
         }
+    }
+
+    MeshMetrics metrics{.messages_received = messages_received_.load(std::memory_order_relaxed),
+                        .answers_sent = answers_sent_.load(std::memory_order_relaxed),
+                        .binary_peers = binary_peer_count_.load(std::memory_order_relaxed),
+                        .content_types_refused = content_types_refused_.load(std::memory_order_relaxed),
+                        .message_boxes = {},
+                        .inboxes = {}};
+    metrics.message_boxes.reserve(message_boxes.size());
+    for (const auto& message_box : message_boxes) {
+        metrics.message_boxes.push_back(message_box->GetMetrics());
+    }
+    metrics.inboxes.reserve(inboxes.size());
+    for (const auto& inbox : inboxes) {
+        metrics.inboxes.push_back(inbox->GetMetrics());
+    }
+    return metrics;
+}
 
-        SendPendingAnswers();
+void ZMesh::DumpTrace(std::ostream& out, TraceFormat format) const {
+    recorder_->Dump(out, format);
+}
 
-        if (stop_token.stop_requested()) {
-            break;
+void ZMesh::ReceiveFromRouter(zmq::socket_t& router) {
+    RouterFrames message;
+    message.count = RecvMultipart(router, message.frames, "request");
+    if (message.count < 2) {
+        return;
+    }
+    messages_received_.fetch_add(1, std::memory_order_relaxed);
+
+    // Stamped here, not by the pipeline worker that dispatches it. Only traced
+    // questions and text messages have six frames.
+    if (message.count == 6) {
+        const auto header = DecodeWireHeader(message.frames[1].data(), message.frames[1].size());
+        if (header && (header->flags & kWireFlagTraced) != 0) {
+            message.received_at = std::chrono::steady_clock::now();
         }
     }
+
+    const auto& identity = message.frames[0];
+    const std::string_view dealer_identity(static_cast<const char*>(identity.data()), identity.size());
+    if (IsBinaryPeerIdentity(dealer_identity) && !binary_peers_.contains(dealer_identity)) {
+        GreetBinaryPeer(router, dealer_identity);
+    }
+
+    if (pipeline_) {
+        pipeline_->Submit(message);
+    } else {
+        DispatchFrames(message);
+    }
 }
 
-void ZMesh::DispatchTell(const std::string& message_box_name,
-                         const std::string& content_type,
-                         const std::string& content) {
-    std::shared_ptr<AbstractMessageBox> message_box;
-    {
-        std::lock_guard lock(message_boxes_mutex_);
-        auto it = message_boxes_.find(message_box_name);
-        if (it != message_boxes_.end()) {
-            message_box = it->second;
+void ZMesh::DispatchFrames(RouterFrames& message) {
+    auto& frames = message.frames;
+    const auto frame_count = message.count;
+
+    if (const auto header = DecodeWireHeader(frames[1].data(), frames[1].size())) {
+        if (header->type == MessageType::Tell && (header->flags & kWireFlagBatch) != 0) {
+            if (frame_count == 4) {
+                DispatchTellBatch(FrameToView(frames[2]), std::move(frames[3]));
+            }
+            return;
+        }
+        const bool traced = header->type == MessageType::Question && (header->flags & kWireFlagTraced) != 0;
+        if (frame_count != (traced ? 6 : 5)) {
+            return;
+        }
+        if (header->type != MessageType::Tell && header->type != MessageType::Question) {
+            return;
+        }
+        const auto content_type = PeerContentType(FrameToView(frames[3]));
+        if (!content_type) {
+            if (header->type == MessageType::Question) {
+                RejectQuestion(FrameToString(frames[0], false),
+                               FrameToString(frames[2]),
+                               header->correlation_id,
+                               "Too many content types to accept " + FrameToString(frames[3]));
+            }
+            return;
+        }
+        auto content = ReceiveContent(*header, *content_type, std::move(frames[4]));
+        if (!content) {
+            if (header->type == MessageType::Question) {
+                RejectQuestion(FrameToString(frames[0], false),
+                               FrameToString(frames[2]),
+                               header->correlation_id,
+                               "Content failed to decompress");
+            } else {
+                ReportError(options_.on_error,
+                            std::make_exception_ptr(std::runtime_error(
+                                "Dropped a Tell to " + FrameToString(frames[2]) + " that failed to decompress")));
+            }
+            return;
+        }
+        if (header->type == MessageType::Tell && (header->flags & kWireFlagChunk) != 0) {
+            DispatchChunk(FrameToView(frames[2]),
+                          PendingChunk{.dealer_identity = FrameToString(frames[0], false),
+                                       .stream_id = header->correlation_id,
+                                       .content_type = *content_type,
+                                       .content = std::move(*content),
+                                       .last = (header->flags & kWireFlagLastChunk) != 0,
+                                       .aborted = (header->flags & kWireFlagRejected) != 0,
+                                       .answer_queue = answer_queue_});
+        } else if (header->type == MessageType::Tell) {
+            DispatchTell(FrameToView(frames[2]), *content_type, std::move(*content));
+        } else {
+            const auto trace_id = traced ? DecodeTraceFrame(frames[5].data(), frames[5].size()) : 0;
+            recorder_->Record(trace_id, TraceStage::RouterReceived, message.received_at);
+            DispatchQuestion(FrameToString(frames[0], false),
+                             QuestionMessage{.message_box_name = FrameToString(frames[2]),
+                                             .correlation_id = header->correlation_id,
+                                             .content_type = *content_type,
+                                             .content = std::move(*content),
+                                             .trace_id = trace_id});
+        }
+        return;
+    }
+
+    if (frame_count != 6) {
+        return;
+    }
+
+    MessageType message_type;
+    try {
+        message_type = message_type_from_string(FrameToString(frames[1]));
+    } catch (...) {
+        return;
+    }
+
+    // Text peers cannot receive a rejection, so these are just dropped.
+    const auto content_type = PeerContentType(FrameToView(frames[4]));
+    if (!content_type) {
+        return;
+    }
+    // A Tell with a correlation id is a whole stream from a native dealer
+    // that had not been greeted yet.
+    if (message_type == MessageType::Tell) {
+        if (const auto stream_id = ParseCorrelationId(FrameToView(frames[3]))) {
+            DispatchChunk(FrameToView(frames[2]),
+                          PendingChunk{.dealer_identity = FrameToString(frames[0], false),
+                                       .stream_id = *stream_id,
+                                       .content_type = *content_type,
+                                       .content = Payload::FromFrame(std::move(frames[5])),
+                                       .last = true,
+                                       .aborted = false,
+                                       .answer_queue = nullptr});
+        } else {
+            DispatchTell(FrameToView(frames[2]), *content_type, Payload::FromFrame(std::move(frames[5])));
         }
+    } else if (message_type == MessageType::Question) {
+        auto text_correlation_id = FrameToString(frames[3]);
+        const auto correlation_id = ParseCorrelationId(text_correlation_id).value_or(0);
+        DispatchQuestion(FrameToString(frames[0], false),
+                         QuestionMessage{.message_box_name = FrameToString(frames[2]),
+                                         .correlation_id = correlation_id,
+                                         .text_correlation_id = std::move(text_correlation_id),
+                                         .content_type = *content_type,
+                                         .content = Payload::FromFrame(std::move(frames[5]))});
     }
+}
 
-    if (!message_box) {
-        message_box = std::dynamic_pointer_cast<AbstractMessageBox>(At(message_box_name));
+std::optional<Payload> ZMesh::ReceiveContent(const WireHeader& header,
+                                             ContentType content_type,
+                                             zmq::message_t&& frame) const {
+    if ((header.flags & kWireCompressionFlags) == 0) {
+        return Payload::FromFrame(std::move(frame));
+    }
+    std::string content;
+    if (!compressor_.Decompress(content_type, header.flags, FrameToView(frame), content)) {
+        return std::nullopt;
     }
+    return Payload(std::move(content));
+}
 
-    if (message_box) {
-        message_box->ReceiveTell(TellMessage{.message_box_name = message_box_name,
-                                             .content_type = content_type,
-                                             .content = content});
+void ZMesh::GreetBinaryPeer(zmq::socket_t& router, std::string_view dealer_identity) {
+    if (const auto previous = previous_binary_peers_.find(dealer_identity); previous != previous_binary_peers_.end()) {
+        binary_peers_.insert(previous_binary_peers_.extract(previous));
+        return;
     }
+
+    // Only a new peer starts a generation, so the sets grow with the dealers
+    // that connected within the last two generations and no further.
+    const auto now = std::chrono::steady_clock::now();
+    const auto age = now - binary_peers_since_;
+    if (age >= options_.peer_idle_timeout) {
+        if (age >= 2 * options_.peer_idle_timeout) {
+            previous_binary_peers_.clear();
+            binary_peers_.clear();
+        } else {
+            previous_binary_peers_ = std::exchange(binary_peers_, {});
+        }
+        binary_peers_since_ = now;
+    }
+
+    const auto& greeted = *binary_peers_.emplace(dealer_identity).first;
+    binary_peer_count_.store(binary_peers_.size() + previous_binary_peers_.size(), std::memory_order_relaxed);
+    SendHello(router, greeted);
 }
 
-void ZMesh::DispatchQuestion(const std::string& dealer_identity,
-                             const std::string& message_box_name,
-                             const std::string& correlation_id,
-                             const std::string& content_type,
-                             const std::string& content) {
-    std::shared_ptr<AbstractMessageBox> message_box;
-    {
-        std::lock_guard lock(message_boxes_mutex_);
-        auto it = message_boxes_.find(message_box_name);
-        if (it != message_boxes_.end()) {
-            message_box = it->second;
+void ZMesh::SendHello(zmq::socket_t& router, const std::string& dealer_identity) {
+    const auto header = EncodeWireHeader(WireHeader{.type = MessageType::Hello});
+    auto& frames = PeerFrames(dealer_identity);
+    frames.Add(zmq::buffer(dealer_identity), true);
+    frames.Add(zmq::buffer(header), false);
+    SendToPeer(router, dealer_identity);
+}
+
+FrameWriter& ZMesh::PeerFrames(std::string_view dealer_identity) {
+    const auto blocked = blocked_peers_.find(dealer_identity);
+    return blocked != blocked_peers_.end() ? blocked->second.frames : router_frames_;
+}
+
+void ZMesh::SendToPeer(zmq::socket_t& router, std::string_view dealer_identity) {
+    if (router_frames_.empty() || router_frames_.Send(router)) {
+        return;
+    }
+    // Only this peer's pipe is full; its messages wait on their own so the
+    // other peers' keep flowing. A router is writable as soon as any one peer
+    // is, so POLLOUT would spin; the blocked peers are retried on a timer.
+    const auto retry_at = std::chrono::steady_clock::now() + kRouterRetryDelay;
+    blocked_peers_.emplace(std::string(dealer_identity),
+                           BlockedPeer{.frames = std::exchange(router_frames_, FrameWriter{}),
+                                       .retry_delay = kRouterRetryDelay,
+                                       .retry_at = retry_at});
+    reactor_->ScheduleAt(*router_channel_, retry_at);
+}
+
+void ZMesh::SendBlockedPeers(zmq::socket_t& router) {
+    if (blocked_peers_.empty()) {
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    auto next_retry = std::chrono::steady_clock::time_point::max();
+    for (auto it = blocked_peers_.begin(); it != blocked_peers_.end();) {
+        auto& blocked = it->second;
+        if (blocked.retry_at > now) {
+            next_retry = std::min(next_retry, blocked.retry_at);
+            ++it;
+            continue;
+        }
+        if (blocked.frames.Send(router)) {
+            it = blocked_peers_.erase(it);
+            continue;
         }
+        blocked.retry_delay = std::min(blocked.retry_delay * 2, BlockedPeer::Duration(kMaxRouterRetryDelay));
+        blocked.retry_at = now + blocked.retry_delay;
+        next_retry = std::min(next_retry, blocked.retry_at);
+        ++it;
     }
+    if (!blocked_peers_.empty()) {
+        reactor_->ScheduleAt(*router_channel_, next_retry);
+    }
+}
 
-    if (!message_box) {
-        message_box = std::dynamic_pointer_cast<AbstractMessageBox>(At(message_box_name));
+void ZMesh::DispatchTell(std::string_view message_box_name,
+                         ContentType content_type,
+                         Payload content) {
+    if (auto inbox = FindOrCreateInbox(message_box_name)) {
+        inbox->ReceiveTell(content_type, std::move(content));
     }
+}
 
-    if (message_box) {
-        PendingQuestion pending_question{.dealer_identity = dealer_identity,
-                                         .question_message = QuestionMessage{.message_box_name = message_box_name,
-                                                                              .correlation_id = correlation_id,
-                                                                              .content_type = content_type,
-                                                                              .content = content},
-                                         .answer_queue = answer_queue_};
-        message_box->ReceiveQuestion(pending_question);
+void ZMesh::DispatchTellBatch(std::string_view message_box_name, zmq::message_t&& records) {
+    auto inbox = FindOrCreateInbox(message_box_name);
+    if (!inbox) {
+        return;
+    }
+
+    // Every record's payload views the one received frame.
+    auto owner = std::make_shared<const zmq::message_t>(std::move(records));
+    const std::string_view view(static_cast<const char*>(owner->data()), owner->size());
+    ForEachBatchRecord(view, [this, &inbox, &owner](std::string_view content_type, std::string_view content) {
+        if (const auto type = PeerContentType(content_type)) {
+            inbox->ReceiveTell(*type, Payload(owner, content));
+        }
+    });
+}
+
+void ZMesh::DispatchChunk(std::string_view message_box_name, PendingChunk pending_chunk) {
+    if (auto inbox = FindOrCreateInbox(message_box_name)) {
+        inbox->ReceiveChunk(std::move(pending_chunk));
     }
 }
 
-void ZMesh::SendPendingAnswers() {
-    if (!router_) {
+void ZMesh::RejectQuestion(std::string dealer_identity,
+                           std::string message_box_name,
+                           CorrelationId correlation_id,
+                           std::string reason) {
+    answer_queue_->push(IdentityMessage<AnswerMessage>{
+        .dealer_identity = std::move(dealer_identity),
+        .message = AnswerMessage{.message_box_name = std::move(message_box_name),
+                                 .correlation_id = correlation_id,
+                                 .text_correlation_id = {},
+                                 .content_type = {},
+                                 .content = std::move(reason),
+                                 .rejected = true,
+                                 .stream_credit = false,
+                                 .trace_id = 0}});
+}
+
+void ZMesh::DispatchQuestion(const std::string& dealer_identity, QuestionMessage question_message) {
+    auto inbox = FindOrCreateInbox(question_message.message_box_name);
+    if (!inbox) {
+        // Text peers cannot receive a rejection; their Ask times out.
+        if (IsBinaryPeerIdentity(dealer_identity)) {
+            RejectQuestion(dealer_identity,
+                           question_message.message_box_name,
+                           question_message.correlation_id,
+                           "Unknown message box: " + question_message.message_box_name);
+        }
         return;
     }
 
+    const auto trace_id = question_message.trace_id;
+    recorder_->Record(trace_id, TraceStage::Dispatched);
+    PendingQuestion pending_question{.dealer_identity = dealer_identity,
+                                     .question_message = std::move(question_message),
+                                     .answer_queue = answer_queue_,
+                                     .local_reply = {},
+                                     .recorder = trace_id != 0 ? recorder_ : nullptr};
+    inbox->ReceiveQuestion(std::move(pending_question));
+}
+
+std::optional<ContentType> ZMesh::PeerContentType(std::string_view name) {
+    auto content_type = ContentType::FromPeer(name, peer_content_types_);
+    if (!content_type) {
+        content_types_refused_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return content_type;
+}
+
+std::shared_ptr<MessageInbox> ZMesh::FindOrCreateInbox(std::string_view name) {
+    {
+        std::shared_lock lock(inboxes_mutex_);
+        auto it = inboxes_.find(name);
+        if (it != inboxes_.end()) {
+            return it->second;
+        }
+    }
+
+    std::string box_name(name);
+    if (!system_map_.contains(box_name)) {
+        return nullptr;
+    }
+
+    std::lock_guard lock(inboxes_mutex_);
+    auto& inbox = inboxes_[box_name];
+    if (!inbox) {
+        inbox = std::make_shared<MessageInbox>(box_name, *executor_, options_.inbox_limit);
+    }
+    return inbox;
+}
+
+void ZMesh::SendPendingAnswers(zmq::socket_t& router) {
+    SendBlockedPeers(router);
+    answer_queue_->rearm();
+
     IdentityMessage<AnswerMessage> identity_message;
     while (answer_queue_->try_pop(identity_message)) {
-        EnsureSend(*router_, zmq::buffer(identity_message.dealer_identity), zmq::send_flags::sndmore, "answer identity");
-        EnsureSend(*router_,
-                   zmq::buffer(std::string(to_string(MessageType::Answer))),
-                   zmq::send_flags::sndmore,
-                   "answer type");
-        EnsureSend(*router_,
-                   zmq::buffer(identity_message.message.message_box_name),
-                   zmq::send_flags::sndmore,
-                   "answer message box");
-        EnsureSend(*router_,
-                   zmq::buffer(identity_message.message.correlation_id),
-                   zmq::send_flags::sndmore,
-                   "answer correlation");
-        EnsureSend(*router_,
-                   zmq::buffer(identity_message.message.content_type),
-                   zmq::send_flags::sndmore,
-                   "answer content type");
-        EnsureSend(*router_, zmq::buffer(identity_message.message.content), zmq::send_flags::none, "answer content");
+        const auto& dealer_identity = identity_message.dealer_identity;
+        const auto& answer = identity_message.message;
+        const auto binary = IsBinaryPeerIdentity(dealer_identity);
+        // Text peers have no way to receive a rejection; their Ask times out.
+        if (answer.rejected && !binary) {
+            continue;
+        }
+
+        auto& frames = PeerFrames(dealer_identity);
+        // A full peer's backlog is capped like an outgoing queue; answers past
+        // it are dropped and their Asks time out. Credits are not: a stream's
+        // window already bounds them, and losing one would stall the stream.
+        const auto capacity = options_.outgoing_limit.capacity;
+        if (&frames != &router_frames_ && !answer.stream_credit && capacity != 0 &&
+            frames.message_count() >= capacity) {
+            continue;
+        }
+
+        if (answer.stream_credit) {
+            const auto header = EncodeWireHeader(WireHeader{
+                .type = MessageType::Answer, .flags = kWireFlagChunk, .correlation_id = answer.correlation_id});
+            frames.Add(zmq::buffer(dealer_identity), true);
+            frames.Add(zmq::buffer(header), true);
+            frames.Add(zmq::buffer(answer.message_box_name), true);
+            frames.Add(zmq::const_buffer{}, true);
+            frames.Add(zmq::const_buffer{}, false);
+        } else if (binary) {
+            answers_sent_.fetch_add(1, std::memory_order_relaxed);
+            std::string compressed;
+            const auto content_type = ContentType::Find(answer.content_type).value_or(ContentType{});
+            const auto compression =
+                answer.rejected ? std::uint16_t{0} : compressor_.Compress(content_type, answer.content, compressed);
+            const auto flags = static_cast<std::uint16_t>((answer.rejected ? kWireFlagRejected : 0) | compression);
+            const auto header = EncodeWireHeader(
+                WireHeader{.type = MessageType::Answer, .flags = flags, .correlation_id = answer.correlation_id});
+            frames.Add(zmq::buffer(dealer_identity), true);
+            frames.Add(zmq::buffer(header), true);
+            frames.Add(zmq::buffer(answer.message_box_name), true);
+            frames.Add(zmq::buffer(answer.content_type), true);
+            frames.Add(zmq::buffer(compression != 0 ? compressed : answer.content), false);
+            recorder_->Record(answer.trace_id, TraceStage::AnswerSent);
+        } else {
+            answers_sent_.fetch_add(1, std::memory_order_relaxed);
+            const auto correlation_id = answer.text_correlation_id.empty()
+                                            ? FormatCorrelationId(answer.correlation_id)
+                                            : answer.text_correlation_id;
+            frames.Add(zmq::buffer(dealer_identity), true);
+            frames.Add(zmq::buffer(to_string(MessageType::Answer)), true);
+            frames.Add(zmq::buffer(answer.message_box_name), true);
+            frames.Add(zmq::buffer(correlation_id), true);
+            frames.Add(zmq::buffer(answer.content_type), true);
+            frames.Add(zmq::buffer(answer.content), false);
+            recorder_->Record(answer.trace_id, TraceStage::AnswerSent);
+        }
+        SendToPeer(router, dealer_identity);
     }
 }
 
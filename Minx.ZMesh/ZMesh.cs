@@ -68,6 +68,14 @@ namespace Minx.ZMesh
             var contentType = e.Socket.ReceiveFrameString();
             var content = e.Socket.ReceiveFrameString();
 
+            // Only Tells and Questions are addressed to a box. Older native
+            // dealers sent an Answer to find out whether the router was native;
+            // it must not create the box.
+            if (messageType != MessageType.Tell && messageType != MessageType.Question)
+            {
+                return;
+            }
+
             var messageBox = (TypedMessageBox)At(messageBoxName);
 
             switch (messageType)